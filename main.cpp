@@ -16,11 +16,40 @@ Pretty cool points:
 
 #include <iostream>
 #include <iomanip>
+#include <fstream>
 #include <stdlib.h>
 #include <complex>
 #include <vector>
 #include <limits>       // std::numeric_limits
 #include <time.h>	    // Time Measurement
+#include <chrono>
+#ifdef WITH_FLOAT128
+#include <quadmath.h>   // __float128, link with -lquadmath
+#endif
+#include <string>
+#include <map>
+#include <algorithm>
+#include <cctype>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+#include <string.h>     // memcpy
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>    // file mapping of MappedRaster, process id of the tile cache
+#include <io.h>         // _setmode of -stream=-
+#include <fcntl.h>
+#include <stdio.h>
+#else
+#include <fcntl.h>      // mmap of MappedRaster
+#include <sys/mman.h>
+#include <unistd.h>     // getpid of the tile cache
+#endif
+#include <charconv>     // from_chars of the options, to_chars of the field
+#include <filesystem>   // create_directories of TilePyramid and the tile cache
+#include <sstream>      // names of the temporary files of the tile cache
 
 // constant long double
 #define CLD const long double
@@ -43,67 +72,2235 @@ void calcVectorAtZ(T z, vector<T> *vec)
     }
 }
 
+/** Name and limits of the scalar types the kernels are instantiated with.
+expLimit is the largest argument of exp that does not overflow.
+*/
+template<class T> struct ScalarTraits;
+
+template<> struct ScalarTraits<float>
+{
+    static const char *name() { return "float"; }
+    static long double epsilon() { return numeric_limits<float>::epsilon(); }
+    static long double expLimit() { return logl(numeric_limits<float>::max()); }
+};
+
+template<> struct ScalarTraits<double>
+{
+    static const char *name() { return "double"; }
+    static long double epsilon() { return numeric_limits<double>::epsilon(); }
+    static long double expLimit() { return logl(numeric_limits<double>::max()); }
+};
+
+template<> struct ScalarTraits<long double>
+{
+    static const char *name() { return "long double"; }
+    static long double epsilon() { return numeric_limits<long double>::epsilon(); }
+    static long double expLimit() { return logl(numeric_limits<long double>::max()); }
+};
+
+#ifdef WITH_FLOAT128
+template<> struct ScalarTraits<__float128>
+{
+    static const char *name() { return "__float128"; }
+    static long double epsilon() { return FLT128_EPSILON; }
+    static long double expLimit() { return logq(FLT128_MAX); }
+};
+#endif
+
+/** exp and abs of the kernels, overloaded for scalar types std::complex has no functions for.
+*/
+template<class T>
+inline complex<T> cexpT(const complex<T> &z)
+{
+    return exp(z);
+}
+
+template<class T>
+inline T cabsT(const complex<T> &z)
+{
+    return abs(z);
+}
+
+#ifdef WITH_FLOAT128
+inline complex<__float128> cexpT(const complex<__float128> &z)
+{
+    __float128 s, c;
+    sincosq(z.imag(), &s, &c);
+    __float128 e = expq(z.real());
+    return complex<__float128>(e * c, e * s);
+}
+
+inline __float128 cabsT(const complex<__float128> &z)
+{
+    return hypotq(z.real(), z.imag());
+}
+#endif
+
+// Longest cycle searched by CycleDetectDLONG.
+#define CYCLEMAX 255
+// Cycle tolerances are raised to this many ulps of the compared values, an eps below the resolution of
+// the scalar type would otherwise read the jitter of a converged orbit in its last bits as a longer cycle.
+#define CYCLEULPS 16.
+
+/** History of an orbit for the cycle detection.
+With window == 0 every step is kept (the old VECLENGTH-sized vector). Otherwise only the last
+entries are kept in a ring of at least window entries, rounded up to a power of two, so the memory
+per point does not depend on the number of steps.
+*/
+template<class T>
+class OrbitHistory
+{
+public:
+    OrbitHistory(unsigned int steps, unsigned int window = 0) : maxSteps(steps), count(0)
+    {
+        unsigned int capacity = steps;
+        mask = ~0u;
+        if (window > 0 && window < steps)
+        {
+            for (capacity = 1; capacity < window; capacity <<= 1)
+                ;
+            mask = capacity - 1;
+        }
+        buf.resize(capacity);
+    }
+
+    /** Forget the entries of the last orbit. */
+    void clear() { count = 0; }
+    /** Append the next step. */
+    void push(const complex<T> &v) { buf[count++ & mask] = v; }
+    /** Maximum number of steps of an orbit. */
+    unsigned int steps() const { return maxSteps; }
+    /** Number of steps pushed since clear(). */
+    unsigned int size() const { return count; }
+    /** Number of entries kept, back(k) is valid for k < min(size(), capacity()). */
+    unsigned int capacity() const { return (unsigned int)buf.size(); }
+    /** Entry k steps before the last one, k must be below min(size(), ring size). */
+    const complex<T> &back(unsigned int k) const { return buf[(count - 1 - k) & mask]; }
+    /** All entries in order of the steps, only meaningful for a full history. */
+    const vector<complex<T> > &data() const { return buf; }
+
+private:
+    vector<complex<T> > buf;
+    unsigned int mask;
+    unsigned int maxSteps;
+    unsigned int count;
+};
+
+template<class T> class CycleWatch;
+
+/**Routine description:
+Arguments:
+- z
+- hist   receives the orbit
+- watch  optional in-loop cycle detection, the orbit stops as soon as it confirms a cycle
+- escape optional, receives the order n at which the orbit diverged, 0 if it did not
+- overflowZero  an overflow whose next step underflows to zero returns the order of that zero instead
+                of -1. Off by default: the decision rests on the phase of an argument of order 1e300,
+                which no precision resolves.
+Return Value:
+ return 0: everything filled or cycle confirmed by watch, nothing found
+ return positive: found cycle over (0.0, 0.0)
+ return negative: found NaN or exp overflow, calculation interrupted!
+*/
+template<class T>
+int safeCalcLongAtZ(complex<T> z, OrbitHistory<T> *hist, CycleWatch<T> *watch = 0, int *escape = 0,
+                    bool overflowZero = false)
+{
+    complex<T> func = 1.;               // Current value of function
+    double safezero = pow(10., -18.);   // Null detection
+    const T expLimit = ScalarTraits<T>::expLimit();     // Divergence detection
+
+    hist->clear();
+    if (watch)
+        watch->reset(z);
+    if (escape)
+        *escape = 0;
+    int n = 1;                          // Count the order
+    for (unsigned int step = 0; step < hist->steps(); ++step)
+    {
+        ++n;
+        const complex<T> w = z * func;
+        if (w.real() > expLimit)
+        {
+            // exp overflows. Depending on the direction of z * F(n) the next step either overflows
+            // again and the orbit runs through inf into NaN, or it underflows to zero:
+            if (overflowZero && (z * cexpT(complex<T>(0, w.imag()))).real() < 0)
+            {
+                return n + 1;
+            }
+            if (escape)
+                *escape = n;
+            return -1;
+        }
+        func = cexpT(w);
+        hist->push(func);
+        if (func != func)
+        {
+            // Found NaN:
+            if (escape)
+                *escape = n;
+            return -1;
+        }
+        if (cabsT(func) < safezero)
+        {
+            return n;
+        }
+        if (watch && watch->check(hist) > 0)
+        {
+            return 0;
+        }
+    }
+    return 0;
+}
+
 /**Routine description:
 Arguments:
 Return Value:
- return 0: everything filled, nothing found
- return positive: found cycle over (0.0, 0.0)
- return negative: found NaN, calculation interrupted!
 */
-int safeCalcLongAtZ(complex<long double> z, vector<complex<long double> > *myvec)
+template<class T>
+int CycleDetectDLONG(const OrbitHistory<T> *hist, double eps = pow(10, -6), int mymax = CYCLEMAX)
+{
+    //    cout << "cycleDetect1 with eps= "<<eps<<endl;
+    int result = 0;
+    const int last = (int)hist->size() - 1;
+    if (last < 0)
+        return 0;
+    complex<T> lastElem = hist->back(0);
+    for (int k = 1; k <= last && k <= mymax; ++k)
+    {
+        ++result;
+        if (cabsT(hist->back(k) - lastElem) < eps)
+        {
+            return result;
+        }
+    }
+    return 0;
+}
+
+/** Cycle detection of calcMField. */
+enum CycleMode
+{
+    CYCLE_SCAN,     // CycleDetectDLONG after the full number of steps
+    CYCLE_BRENT,    // CycleWatch inside the iteration, stops at a confirmed cycle
+    CYCLE_NEWTON    // CycleWatch with Newton refinement of candidate cycles
+};
+
+/** In-loop cycle detection with Brent's power-of-two checkpoints.
+The step just pushed is compared with the last checkpoint. On a match the smallest lag p is taken
+from CycleDetectDLONG and watched. A converging orbit cannot be stopped early without risking another
+answer than CycleDetectDLONG after the full number of steps: slowly converging lags dividing p, or lags
+whose distance jitters around the tolerance, decide differently at the last step. So p is only confirmed
+once F(n) = F(n-p) exactly, from then on the orbit repeats itself up to the end and the result of
+CycleDetectDLONG at the last step is taken from the history. Orbits that never repeat exactly are left
+to run to the end.
+With CYCLE_NEWTON checkpoints match within a loose tolerance instead and the candidate is handed to
+refine(), which confirms it without waiting for the orbit to converge.
+Periods hinted by the neighbours of a point are compared at every step, so a matching lag is watched
+as soon as the orbit closes up instead of at the next checkpoint match.
+The tolerance is max(eps, relTol * |F|), relTol > 0 keeps it above the resolution of T.
+*/
+template<class T>
+class CycleWatch
+{
+public:
+    CycleWatch(double eps, double relTol = 0, CycleMode mode = CYCLE_BRENT)
+        : eps(eps), relTol(relTol), newton(mode == CYCLE_NEWTON), z(0) { hint(0, 0); reset(z); }
+
+    /** Periods to compare at every step, 0 for none. Kept by reset(), so set them before every point. */
+    void hint(int p1, int p2)
+    {
+        hints[0] = p1 > 0 && p1 <= CYCLEMAX ? p1 : 0;
+        hints[1] = p2 > 0 && p2 <= CYCLEMAX && p2 != p1 ? p2 : 0;
+    }
+
+    /** Start watching the orbit of a new point z. */
+    void reset(const complex<T> &z)
+    {
+        this->z = z;
+        power = 1;
+        lam = 0;
+        period = 0;
+        left = 0;
+        locked = false;
+        tried = 0;
+        mult = 0;
+    }
+
+    /** Tolerance for comparisons with x. */
+    double tolerance(const complex<T> &x) const
+    {
+        return relTol > 0 ? max(eps, relTol * (double)cabsT(x)) : eps;
+    }
+
+    /**Routine description: Check the step just pushed to hist.
+    Arguments:
+    - hist
+    Return Value:
+     period of the cycle once it is confirmed, 0 otherwise
+    */
+    int check(const OrbitHistory<T> *hist)
+    {
+        const complex<T> &x = hist->back(0);
+        const double tol = tolerance(x);
+        if (newton)
+        {
+            // One refinement per checkpoint at most, a failed candidate is not retried every step.
+            const double loose = max(tol, 1e-3 * (1. + (double)cabsT(x)));
+            if (hist->size() > 1 && tried != power && cabsT(x - saved) < loose)
+            {
+                tried = power;
+                const int p = CycleDetectDLONG(hist, loose);
+                if (p > 0 && refine(x, p, tol))
+                {
+                    period = p;
+                    left = 0;
+                    locked = true;
+                    return p;
+                }
+            }
+        }
+        else if (period > 0)
+        {
+            const double dist = (double)cabsT(x - hist->back(period));
+            if (dist >= tol)
+                period = 0;     // Lock lost, go on with the checkpoints
+            else if (dist == 0 || --left == 0)
+                return confirm(hist, tol, dist);
+            return 0;
+        }
+        if (!newton)
+        {
+            // Squared distance, this runs at every step
+            for (int i = 0; i < 2 && period == 0; ++i)
+            {
+                if (hints[i] > 0 && (int)hist->size() > hints[i])
+                {
+                    const complex<T> d = x - hist->back(hints[i]);
+                    if (d.real() * d.real() + d.imag() * d.imag() < T(tol) * T(tol))
+                        watch(hist, tol);
+                }
+            }
+        }
+        if (period == 0 && hist->size() > 1 && cabsT(x - saved) < tol)
+            watch(hist, tol);
+        if (++lam >= power)
+        {
+            saved = x;
+            power <<= 1;
+            lam = 0;
+        }
+        return 0;
+    }
+
+    /** Period confirmed by the last check, 0 if none. */
+    int confirmed() const { return locked ? period : 0; }
+
+    /** |multiplier| of the cycle confirmed by refine(), 0 if none. */
+    double multiplier() const { return mult; }
+
+private:
+    /**Routine description: Newton's method on G(F) = f^p(F) - F with f(F) = exp(z * F), started at x.
+    The derivative of f^p is the cycle multiplier, the product of z * F over the cycle.
+    exp has the single asymptotic value 0, so an attracting cycle attracts the orbit of f(0) = 1:
+    a refined cycle of minimal period p with |multiplier| < 1 is where the orbit ends up.
+    Arguments:
+    - x    current step of the orbit
+    - p    candidate period
+    - tol  tolerance for |f^p(F) - F|
+    Return Value:
+     true if an attracting cycle of minimal period p was found, multiplier() is set
+    */
+    bool refine(complex<T> x, int p, double tol)
+    {
+        const T one = 1;
+        const double resolution = 4. * ScalarTraits<T>::epsilon();
+        for (int it = 0; it < 30; ++it)
+        {
+            complex<T> u = x, m = one;
+            for (int i = 0; i < p; ++i)
+            {
+                u = cexpT(z * u);
+                m *= z * u;
+            }
+            const complex<T> dx = (u - x) / (m - one);
+            if (!(cabsT(dx) < 1e3 * (1. + (double)cabsT(x))))
+                return false;       // Diverged or NaN
+            x -= dx;
+            if ((double)cabsT(dx) <= resolution * (1. + (double)cabsT(x)))
+                break;
+        }
+
+        complex<T> u = x, m = one;
+        for (int i = 1; i <= p; ++i)
+        {
+            u = cexpT(z * u);
+            m *= z * u;
+            if (i < p && p % i == 0 && cabsT(u - x) < tol)
+                return false;       // Not minimal, the divisor shows up on its own
+        }
+        const double absMult = (double)cabsT(m);
+        if (!(absMult < 1.) || !(cabsT(u - x) < tol))
+            return false;
+        mult = absMult;
+        return true;
+    }
+
+    /** Watch the smallest lag matching now for one cycle. */
+    void watch(const OrbitHistory<T> *hist, double tol)
+    {
+        period = CycleDetectDLONG(hist, tol);
+        left = period;
+    }
+
+    /** Watched lag with |F(n) - F(n-period)| = dist, at the end of a cycle or exactly periodic. */
+    int confirm(const OrbitHistory<T> *hist, double tol, double dist)
+    {
+        if (dist != 0)
+        {
+            watch(hist, tol);   // Still converging or jittering in the last bits, watch the next cycle
+            return 0;
+        }
+        // F(n) = F(n-p) exactly, so the orbit repeats the last p steps up to the end, where
+        // CycleDetectDLONG compares F(N) = back(a) with F(N-k) = back((a + k) mod p).
+        const int p = period;
+        const int a = (p - (int)((hist->steps() - hist->size()) % p)) % p;
+        const double tolEnd = tolerance(hist->back(a));
+        int k = 1;
+        while (k < p && !((double)cabsT(hist->back(a) - hist->back((a + k) % p)) < tolEnd))
+            ++k;
+        period = k;
+        locked = true;
+        return k;
+    }
+
+    double eps, relTol;
+    bool newton;
+    int hints[2];               // Periods of the neighbours
+    complex<T> z;               // Point of the orbit
+    complex<T> saved;           // Checkpoint
+    unsigned int power, lam;    // Steps between checkpoints, steps since the last one
+    int period, left;           // Watched lag and steps left in its cycle
+    bool locked;
+    unsigned int tried;         // Checkpoint of the last refinement
+    double mult;                // |multiplier| of the refined cycle
+};
+
+/** Optional results per point besides the code, each an array in the layout of the field.
+Only the channels with a non-zero pointer are collected. Points that are not iterated, resolved by
+-lambertw or filled by -subdivide and -progressive, keep the value the arrays were initialised with.
+*/
+struct FieldChannels
+{
+    int *iterations;        // steps of the orbit
+    int *escape;            // order at which the orbit diverged, 0 if it did not
+    float *absF;            // |F| of the last step, the last finite one if exp overflowed, NaN after a NaN step
+    float *argF;            // arg F of the last step
+    float *multiplier;      // |multiplier| of the cycle, 0 without a cycle
+    int *transient;         // steps before the orbit entered its cycle, 0 without a cycle
+
+    FieldChannels() : iterations(0), escape(0), absF(0), argF(0), multiplier(0), transient(0) {}
+};
+
+/**Routine description: Store the channels of a point from its orbit, except the escape order that
+the kernels store while they iterate.
+The multiplier is the product of z * F over the last period steps. The transient counts the steps
+before the orbit came within tol of its cycle, as far as the history reaches back, so with a ring
+history it is an upper bound once the cycle fills the ring.
+Arguments:
+- channels
+- index   of the point in the field
+- hist    orbit of the point
+- z
+- period  cycle length found for the orbit, 0 if it ended without a cycle
+- tol     distance at which two steps of the orbit are the same point of the cycle
+Return Value:
+*/
+template<class T>
+void recordChannels(const FieldChannels &channels, size_t index, const OrbitHistory<T> &hist,
+                    const complex<T> &z, int period, double tol)
+{
+    const unsigned int steps = hist.size();
+    const unsigned int kept = min(steps, hist.capacity());
+    if (channels.iterations)
+        channels.iterations[index] = steps;
+    const complex<double> last = steps > 0 ? complex<double>((double)hist.back(0).real(), (double)hist.back(0).imag())
+                                           : complex<double>(1.);
+    if (channels.absF)
+        channels.absF[index] = (float)abs(last);
+    if (channels.argF)
+        channels.argF[index] = (float)arg(last);
+    if (channels.multiplier)
+    {
+        complex<double> m = 0.;
+        if (period > 0 && (unsigned int)period <= kept)
+        {
+            const complex<double> zd((double)z.real(), (double)z.imag());
+            m = 1.;
+            for (int k = 0; k < period; ++k)
+                m *= zd * complex<double>((double)hist.back(k).real(), (double)hist.back(k).imag());
+        }
+        channels.multiplier[index] = (float)abs(m);
+    }
+    if (channels.transient)
+    {
+        int transient = 0;
+        if (period > 0 && (unsigned int)period <= kept)
+        {
+            unsigned int k = 0;
+            while (k + period < kept && (double)cabsT(complex<T>(hist.back(k) - hist.back(k + period))) < tol)
+                ++k;
+            transient = steps - k - period;
+        }
+        channels.transient[index] = transient;
+    }
+}
+
+//==============================================================
+// Batch kernel: SIMDLANES starting points advanced together in double precision.
+
+#if defined(__AVX512F__)
+#define SIMDLANES 8
+#elif defined(__AVX__)
+#define SIMDLANES 4
+#else
+#define SIMDLANES 2
+#endif
+
+typedef double vdouble __attribute__((vector_size(SIMDLANES * sizeof(double))));
+typedef long long vmask __attribute__((vector_size(SIMDLANES * sizeof(long long))));
+
+/**Routine description: exp(x) in every lane.
+Range reduction x = n*ln2 + r with |r| <= ln2/2, polynomial for exp(r) and scaling by 2^n
+in two steps, so that subnormal results and overflow to inf come out right.
+Arguments:
+- x
+Return Value:
+ exp(x), NaN lanes stay NaN
+*/
+inline vdouble vexp(vdouble x)
+{
+    const double magic = 6755399441055744.0;    // 1.5 * 2^52, rounds to integer
+    vdouble xc = x < -1100. ? -1100. : x;
+    xc = xc > 1100. ? 1100. : xc;
+    vdouble t = xc * 1.4426950408889634074 + magic;
+    vdouble n = t - magic;
+    vdouble r = xc - n * 6.93147180369123816490e-01 - n * 1.90821492927058770002e-10;
+
+    vdouble p = r * (1. / 6227020800.) + 1. / 479001600.;
+    p = p * r + 1. / 39916800.;
+    p = p * r + 1. / 3628800.;
+    p = p * r + 1. / 362880.;
+    p = p * r + 1. / 40320.;
+    p = p * r + 1. / 5040.;
+    p = p * r + 1. / 720.;
+    p = p * r + 1. / 120.;
+    p = p * r + 1. / 24.;
+    p = p * r + 1. / 6.;
+    p = p * r + 0.5;
+    p = p * r + 1.;
+    p = p * r + 1.;
+
+    vmask ni = ((vmask)t << 32) >> 32;          // Integer n from the low mantissa bits
+    vmask n1 = ni >> 1;
+    vmask n2 = ni - n1;
+    vdouble s1 = (vdouble)((n1 + 1023) << 52);
+    vdouble s2 = (vdouble)((n2 + 1023) << 52);
+    vdouble result = p * s1 * s2;
+    return x != x ? x : result;
+}
+
+// Largest |y| for which the reduction of vsincos is accurate.
+#define VSINCOSMAX 1e9
+
+/**Routine description: sin(y) and cos(y) in every lane.
+Cody-Waite reduction by pi/2 and the fdlibm kernel polynomials on [-pi/4, pi/4].
+Accurate as long as |y| stays below VSINCOSMAX, callers handle larger arguments on their own.
+Arguments:
+- y
+- s  receives sin(y)
+- c  receives cos(y)
+Return Value:
+*/
+inline void vsincos(vdouble y, vdouble &s, vdouble &c)
+{
+    const double magic = 6755399441055744.0;
+    vdouble t = y * 6.36619772367581382433e-01 + magic;
+    vdouble q = t - magic;
+    vdouble r = y - q * 1.57079632673412561417e+00;
+    r = r - q * 6.07710050630396597660e-11;
+    r = r - q * 2.02226624879595063154e-21;
+    vmask quadrant = (vmask)t & 3;
+
+    vdouble z = r * r;
+    vdouble ps = z * 1.58969099521155010221e-10 - 2.50507602534068634195e-08;
+    ps = ps * z + 2.75573137070700676789e-06;
+    ps = ps * z - 1.98412698298579493134e-04;
+    ps = ps * z + 8.33333333332248946124e-03;
+    ps = ps * z - 1.66666666666666324348e-01;
+    vdouble sr = r + r * z * ps;
+
+    vdouble pc = z * -1.13596475577881948265e-11 + 2.08757232129817482790e-09;
+    pc = pc * z - 2.75573143513906633035e-07;
+    pc = pc * z + 2.48015872894767294178e-05;
+    pc = pc * z - 1.38888888888741095749e-03;
+    pc = pc * z + 4.16666666666666019037e-02;
+    vdouble cr = 1. - 0.5 * z + z * z * pc;
+
+    vmask swap = (quadrant & 1) != 0;
+    vdouble sv = swap ? cr : sr;
+    vdouble cv = swap ? sr : cr;
+    s = ((quadrant & 2) != 0) ? -sv : sv;
+    c = (((quadrant + 1) & 2) != 0) ? -cv : cv;
+}
+
+/** Lane bookkeeping of safeCalcStreamAtZ. */
+struct LaneStats
+{
+    unsigned long long busy;    // lane-steps spent on a pending point
+    unsigned long long slots;   // lane-steps executed in total
+
+    LaneStats() : busy(0), slots(0) {}
+};
+
+/**Routine description: safeCalcLongAtZ followed by CycleDetectDLONG for a stream of points,
+computed SIMDLANES at a time in double precision.
+A lane is retired as soon as its point left through NaN or zero detection or filled its history,
+and is reloaded with the next pending point, so lanes only idle once the source is exhausted.
+vexp and vsincos are a few ulps off the library functions, so points whose orbit hovers at a tolerance
+can get another code than safeCalcLongAtZ<double>.
+Arguments:
+- next      source of points, next(index, z) returns false when no point is left
+- field     receives the code of point index at field[index], same meaning as calcPointAtZ
+- veclength maximum number of steps
+- eps       tolerance of the cycle detection, raised to a few ulps of the compared values since
+            eps=1e-16 is below double resolution and a converged orbit jitters in its last bits
+- cycle     CYCLE_BRENT or CYCLE_NEWTON stop a lane as soon as CycleWatch confirms a cycle
+- stats     receives the lane utilisation
+- channels  optional, receives the channels of point index
+- overflowZero  see safeCalcLongAtZ
+Return Value:
+*/
+template<class Source>
+void safeCalcStreamAtZ(Source &next, int *field, const int veclength, double eps, CycleMode cycle,
+                       LaneStats &stats, const FieldChannels *channels = 0, bool overflowZero = false)
+{
+    const double safezero = pow(10., -18.);
+    const double expLimit = ScalarTraits<double>::expLimit();
+    vector<OrbitHistory<double> > hist(SIMDLANES, OrbitHistory<double>(veclength, CYCLEMAX + 1));
+    vector<CycleWatch<double> > watch(SIMDLANES, CycleWatch<double>(eps, CYCLEULPS * numeric_limits<double>::epsilon(), cycle));
+    size_t idx[SIMDLANES];
+    bool busy[SIMDLANES];
+    int step[SIMDLANES];
+    vdouble zr, zi, fr, fi, s, c;
+    int active = 0;
+
+    auto load = [&](int l)
+    {
+        complex<double> z;
+        busy[l] = next(idx[l], z);
+        while (busy[l] && veclength == 0)
+        {
+            field[idx[l]] = 0;
+            busy[l] = next(idx[l], z);
+        }
+        zr[l] = z.real();
+        zi[l] = z.imag();
+        fr[l] = 1.;
+        fi[l] = 0.;
+        step[l] = 0;
+        hist[l].clear();
+        watch[l].reset(z);
+        active += busy[l];
+    };
+    for (int l = 0; l < SIMDLANES; ++l)
+        load(l);
+
+    while (active > 0)
+    {
+        vdouble wr = zr * fr - zi * fi;
+        vdouble wi = zr * fi + zi * fr;
+        vdouble e = vexp(wr);
+        vsincos(wi, s, c);
+        for (int l = 0; l < SIMDLANES; ++l)
+        {
+            // Beyond VSINCOSMAX the phase decides whether the next step overflows or underflows to
+            // zero, so these lanes take the fully reduced scalar functions like the scalar kernel.
+            if (!(fabs(wi[l]) < VSINCOSMAX))
+            {
+                s[l] = sin(wi[l]);
+                c[l] = cos(wi[l]);
+            }
+        }
+        fr = e * c;
+        fi = e * s;
+        stats.slots += SIMDLANES;
+        stats.busy += active;
+
+        for (int l = 0; l < SIMDLANES; ++l)
+        {
+            if (!busy[l])
+                continue;
+            int i = step[l]++;
+            // Like safeCalcLongAtZ the history ends with the last finite step if exp overflows
+            const bool overflow = wr[l] > expLimit;
+            if (!overflow)
+                hist[l].push(complex<double>(fr[l], fi[l]));
+            int code, period = 0;
+            if (overflow)               // See safeCalcLongAtZ
+                code = overflowZero && zr[l] * c[l] - zi[l] * s[l] < 0 ? i + 3 : -1;
+            else if (fr[l] != fr[l] || fi[l] != fi[l])
+                code = -1;
+            else if (fr[l] * fr[l] + fi[l] * fi[l] < safezero * safezero)
+                code = i + 2;       // n of safeCalcLongAtZ
+            else if (cycle != CYCLE_SCAN && watch[l].check(&hist[l]) > 0)
+                code = period = watch[l].confirmed();
+            else if (step[l] == veclength)
+                code = period = CycleDetectDLONG(&hist[l], watch[l].tolerance(hist[l].back(0)));
+            else
+                continue;
+            field[idx[l]] = code;
+            if (channels)
+            {
+                if (channels->escape)
+                    channels->escape[idx[l]] = code == -1 ? i + 2 : 0;
+                recordChannels(*channels, idx[l], hist[l], complex<double>(zr[l], zi[l]), period,
+                               watch[l].tolerance(hist[l].back(0)));
+            }
+            --active;
+            load(l);
+        }
+    }
+}
+
+/** Helper function to manipulate output of values at z.
+*/
+template<class T, class S>
+inline void printmy(T m, S z, bool printz = false)
+{
+    printz ? cout << m << " at z=" << z << '\n' : cout << m << " ";
+}
+
+/**Routine description: Principal branch of the Lambert W function, w * exp(w) = x.
+Initial guess from the series at the branch point -1/e, a Pade approximant at 0 or logarithms,
+refined by Halley's method.
+Arguments:
+- x
+- w  receives W0(x)
+Return Value:
+ true if Halley's method converged
+*/
+bool lambertW0(complex<double> x, complex<double> &w)
+{
+    const double e = exp(1.);
+    if (abs(x + 1. / e) < 0.3)
+    {
+        const complex<double> p = sqrt(2. * (e * x + 1.));
+        w = -1. + p * (1. + p * (-1. / 3. + p * (11. / 72.)));
+    }
+    else if (abs(x) < 0.8)
+    {
+        w = x * (60. + x * (114. + x * 17.)) / (60. + x * (174. + x * 101.));
+    }
+    else if (abs(x) > 3.)
+    {
+        const complex<double> l1 = log(x);
+        w = l1 - log(l1);
+    }
+    else if (abs(x + 1.) > 0.3)
+    {
+        w = log(1. + x);
+    }
+    else
+    {
+        w = complex<double>(-0.32, x.imag() < 0 ? -1.34 : 1.34);     // W0(-1)
+    }
+
+    for (int it = 0; it < 40; ++it)
+    {
+        const complex<double> ew = exp(w);
+        const complex<double> f = w * ew - x;
+        const complex<double> wp1 = w + 1.;
+        const complex<double> dw = f / (ew * wp1 - (w + 2.) * f / (2. * wp1));
+        w -= dw;
+        if (!(abs(w) < numeric_limits<double>::max()))
+            return false;
+        if (abs(dw) < 1e-14 * (1. + abs(w)))
+            return true;
+    }
+    return false;
+}
+
+/**Routine description: Closed form test for the region where the continued exponential converges
+(Shell-Thron region). The fixed points of F = exp(z * F) are F = -W(-z)/z with multiplier
+lambda = z * F = -W(-z), the fixed point is attracting for |lambda| < 1 and then attracts the orbit of 1.
+The test only answers true when safeCalcLongAtZ and CycleDetectDLONG in T would certainly return 1:
+|lambda|^(veclength/2) has to shrink the distance below eps, and eps has to lie above the resolution
+of T at F, otherwise the orbit only jitters in its last bits.
+Arguments:
+- z
+- veclength  maximum steps for computation at every point
+- eps
+Return Value:
+ true if the point converges to its fixed point, its code is 1
+*/
+template<class T>
+bool fixedPointAtZ(const complex<T> &z, unsigned int veclength, double eps)
+{
+    const complex<double> zd((double)z.real(), (double)z.imag());
+    complex<double> w;
+    if (!lambertW0(-zd, w))
+        return false;
+    const complex<double> lambda = -w;
+    const double r = abs(lambda);
+    if (!(r < 1.))
+        return false;
+    const double absF = exp(lambda.real());                 // F = exp(z * F) = exp(lambda)
+    if (abs(w * exp(w) + zd) > 1e-12 * (1. + abs(zd)))
+        return false;
+    if (!(eps > 16. * (double)ScalarTraits<T>::epsilon() * absF))
+        return false;
+    return 0.5 * veclength * log(r) < log(eps / (4. * (1. + absF)));
+}
+
+// Number of rows formatted at once by a thread of printField.
+#define PRINTROWS 64
+
+/**Routine description: Format rows of a field as '\n' followed by every value and a blank.
+Arguments:
+- out    receives the text
+- first  first value of the first row
+- rows
+- width
+Return Value:
+*/
+inline void formatRows(string &out, const int *first, size_t rows, unsigned int width)
+{
+    // At most 11 characters for an int plus the blank
+    out.resize(rows * (1 + 12 * (size_t)width));
+    char *p = &out[0];
+    for (size_t row = 0; row < rows; ++row)
+    {
+        *p++ = '\n';
+        for (unsigned int ren = 0; ren < width; ++ren)
+        {
+            p = to_chars(p, p + 11, first[row * width + ren]).ptr;
+            *p++ = ' ';
+        }
+    }
+    out.resize(p - out.data());
+}
+
+/**Routine description: Print a field row by row in the layout of calcMField.
+The text is identical to printing every value with operator<< and a blank. It is formatted with to_chars
+by numThreads threads in blocks of PRINTROWS rows, each round of blocks is written in order.
+Arguments:
+- os
+- field, size  numIm rows of width values, maxIm first
+- width
+- numThreads
+Return Value:
+*/
+void printField(ostream &os, const int *field, size_t size, unsigned int width, unsigned int numThreads = 1)
+{
+    const size_t numRows = width > 0 ? size / width : 0;
+    numThreads = max(1u, numThreads);
+    vector<string> blocks(numThreads);
+    for (size_t row = 0; row < numRows; row += (size_t)numThreads * PRINTROWS)
+    {
+        auto format = [&](unsigned int t)
+        {
+            const size_t first = row + (size_t)t * PRINTROWS;
+            formatRows(blocks[t], &field[first * width], min((size_t)PRINTROWS, numRows - first), width);
+        };
+        vector<thread> pool;
+        for (unsigned int t = 1; t < numThreads && row + (size_t)t * PRINTROWS < numRows; ++t)
+            pool.push_back(thread(format, t));
+        format(0);
+        for (unsigned int t = 0; t < pool.size(); ++t)
+            pool[t].join();
+        for (unsigned int t = 0; t <= pool.size(); ++t)
+            os.write(blocks[t].data(), blocks[t].size());
+    }
+}
+
+/**Routine description: Bytes per value of a binary field, the codes range from -1 to the order
+veclength + 2 of a zero after an overflow.
+Arguments:
+- veclength  maximum steps for computation at every point
+Return Value:
+ 1, 2 or 4 for int8, int16 or int32
+*/
+inline unsigned int fieldValueBytes(unsigned int veclength)
+{
+    if (veclength <= 125)
+        return 1;
+    if (veclength <= 32765)
+        return 2;
+    return 4;
+}
+
+/**Routine description: Write the values of a field as signed integers of type I in native byte order.
+Arguments:
+- os
+- field, size
+Return Value:
+*/
+template<class I>
+void writeFieldValues(ostream &os, const int *field, size_t size)
+{
+    vector<I> buffer(min(size, (size_t)1 << 16));
+    for (size_t start = 0; start < size; start += buffer.size())
+    {
+        const size_t count = min(buffer.size(), size - start);
+        for (size_t i = 0; i < count; ++i)
+            buffer[i] = (I)field[start + i];
+        os.write((const char *)buffer.data(), count * sizeof(I));
+    }
+}
+
+inline void writeFieldValues(ostream &os, const int *field, size_t size, unsigned int bytes)
+{
+    if (bytes == 1)
+        writeFieldValues<int8_t>(os, field, size);
+    else if (bytes == 2)
+        writeFieldValues<int16_t>(os, field, size);
+    else
+        writeFieldValues<int32_t>(os, field, size);
+}
+
+// Recorded in RawHeader and part of the key of the tile cache, to be raised whenever a change of the kernels changes codes.
+#define KERNELVERSION 3
+// Version of RawHeader, readers refuse other versions.
+#define RAWVERSION 2
+// Widest row the readers accept, so a corrupt header cannot request arbitrary memory.
+#define RAWMAXWIDTH (1u << 24)
+// Bits of RawHeader::flags, the switches of MFieldOptions that change codes.
+#define RAWSIMD 1
+#define RAWFULLHISTORY 2
+#define RAWLAMBERTW 4
+#define RAWOVERFLOWZERO 8
+
+/** Header of the binary field written by writeRaw, 96 bytes in native byte order.
+The run configuration after eps is filled in by setRunConfig, zero if unknown.
+*/
+struct RawHeader
+{
+    char magic[4];              // "CEXP"
+    uint32_t version;           // RAWVERSION
+    uint32_t valueBytes;        // 1, 2 or 4 bytes per signed value following the header
+    uint32_t width, height;     // numRe + 1 values per row, numIm rows, maxIm first
+    uint32_t veclength;
+    double minRe, maxRe, minIm, maxIm, eps;
+    char type[16];              // scalar type of the orbits, ScalarTraits<T>::name(), zero padded
+    uint32_t cycle;             // CycleMode
+    uint32_t flags;             // RAWSIMD, RAWFULLHISTORY, RAWLAMBERTW, RAWOVERFLOWZERO
+    uint32_t kernel;            // KERNELVERSION
+    uint32_t reserved;
+};
+
+/**Routine description: RawHeader for a field.
+Arguments:
+- width, height
+- minRe, maxRe, minIm, maxIm, eps, veclength  parameters of calcMField
+- valueBytes  1, 2 or 4
+Return Value:
+*/
+inline RawHeader rawHeader(unsigned int width, unsigned int height, CLD minRe, CLD maxRe, CLD minIm, CLD maxIm,
+                           double eps, unsigned int veclength, unsigned int valueBytes)
+{
+    RawHeader header = {{'C', 'E', 'X', 'P'}, RAWVERSION, valueBytes, width, height, veclength,
+                        (double)minRe, (double)maxRe, (double)minIm, (double)maxIm, eps, {}, 0, 0, 0, 0};
+    return header;
+}
+
+/**Routine description: Write a field as RawHeader followed by the values, row by row in the layout of calcMField.
+Arguments:
+- os         opened in binary mode
+- field, size
+- header     width, height and valueBytes describe field
+Return Value:
+*/
+void writeRaw(ostream &os, const int *field, size_t size, const RawHeader &header)
+{
+    os.write((const char *)&header, sizeof header);
+    writeFieldValues(os, field, size, header.valueBytes);
+}
+
+/** Raw field file of width x height int32 values mapped into memory, see writeRaw for the layout.
+Workers store their results straight into values(), the page cache writes them back, so the field
+may be larger than the memory. POSIX mmap or a Windows file mapping.
+*/
+class MappedRaster
+{
+public:
+    MappedRaster() : base(0), length(0)
+    {
+#ifdef _WIN32
+        file = INVALID_HANDLE_VALUE;
+        mapping = 0;
+#else
+        fd = -1;
+#endif
+    }
+
+    ~MappedRaster() { close(); }
+
+    /**Routine description: Create the file with its final size and map it.
+    Arguments:
+    - path
+    - header  valueBytes has to be 4
+    Return Value:
+     true on success, values() is then zero-filled and the header is written
+    */
+    bool open(const string &path, const RawHeader &header)
+    {
+        close();
+        length = sizeof header + (size_t)header.width * header.height * sizeof(int32_t);
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, 0, CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL, 0);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        mapping = CreateFileMappingA(file, 0, PAGE_READWRITE, (DWORD)((unsigned long long)length >> 32),
+                                     (DWORD)length, 0);
+        if (mapping)
+            base = (char *)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, length);
+#else
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            return false;
+        if (ftruncate(fd, (off_t)length) == 0)
+        {
+            void *p = mmap(0, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            base = p == MAP_FAILED ? 0 : (char *)p;
+        }
+#endif
+        if (!base)
+        {
+            close();
+            return false;
+        }
+        memcpy(base, &header, sizeof header);
+        return true;
+    }
+
+    /** Values of the field after the header, 0 if not open. */
+    int32_t *values() const { return base ? (int32_t *)(base + sizeof(RawHeader)) : 0; }
+
+    /** Unmap and close, the file keeps its contents. */
+    void close()
+    {
+#ifdef _WIN32
+        if (base)
+            UnmapViewOfFile(base);
+        if (mapping)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+        mapping = 0;
+#else
+        if (base)
+            munmap(base, length);
+        if (fd >= 0)
+            ::close(fd);
+        fd = -1;
+#endif
+        base = 0;
+    }
+
+private:
+    MappedRaster(const MappedRaster &);
+    MappedRaster &operator=(const MappedRaster &);
+
+    char *base;
+    size_t length;
+#ifdef _WIN32
+    HANDLE file, mapping;
+#else
+    int fd;
+#endif
+};
+
+/** Streaming output of a field in frames, each a 4 character tag, the uint32 length of the payload
+and the payload, all in native byte order:
+HEAD  RawHeader of the field
+ROW   uint32 row index followed by the width values of the row in the type of the header
+END   uint32 number of rows sent
+Rows are sent in the order in which they are completed and every frame is flushed, so consumers can
+start while the calculation is still running. row() may be called by several threads.
+*/
+class RowStream
+{
+public:
+    RowStream(ostream &os, const RawHeader &header) : os(os), header(header), sent(0)
+    {
+        frame("HEAD", sizeof header);
+        os.write((const char *)&header, sizeof header);
+        os.flush();
+    }
+
+    /** Send row imn of the field. */
+    void row(unsigned int imn, const int *values)
+    {
+        lock_guard<mutex> lock(streamMutex);
+        frame("ROW ", sizeof(uint32_t) + (size_t)header.width * header.valueBytes);
+        const uint32_t index = imn;
+        os.write((const char *)&index, sizeof index);
+        writeFieldValues(os, values, header.width, header.valueBytes);
+        os.flush();
+        ++sent;
+    }
+
+    /** Send the trailer. */
+    void finish()
+    {
+        lock_guard<mutex> lock(streamMutex);
+        frame("END ", sizeof sent);
+        os.write((const char *)&sent, sizeof sent);
+        os.flush();
+    }
+
+private:
+    void frame(const char *tag, size_t length)
+    {
+        const uint32_t len = (uint32_t)length;
+        os.write(tag, 4);
+        os.write((const char *)&len, sizeof len);
+    }
+
+    ostream &os;
+    RawHeader header;
+    uint32_t sent;
+    mutex streamMutex;
+};
+
+// Rows between two keyframes of RleWriter.
+#define RLEKEYFRAME 16
+
+/** Run-length and delta coded field, file layout:
+RawHeader with magic "CEXR" and valueBytes 0, uint32 keyframe interval, the coded rows,
+uint64 file offset of every row and the uint64 file offset of that index.
+A row is a sequence of tokens, each an unsigned LEB128 varint h: h odd is a run of h >> 1 values
+equal to the zigzag varint that follows, h even copies h >> 1 values from the row above. Every
+keyframe-th row uses runs only, so a row decodes from the keyframe before it.
+*/
+class RleWriter
+{
+public:
+    RleWriter(ostream &os, const RawHeader &header, uint32_t keyframe = RLEKEYFRAME)
+        : os(os), width(header.width), keyframe(keyframe), offset(0)
+    {
+        RawHeader h = header;
+        memcpy(h.magic, "CEXR", 4);
+        h.valueBytes = 0;
+        put(&h, sizeof h);
+        put(&keyframe, sizeof keyframe);
+    }
+
+    /** Append the next row of width values. */
+    void row(const int *values)
+    {
+        index.push_back(offset);
+        const bool key = (index.size() - 1) % keyframe == 0;
+        const int *above = key ? 0 : prev.data();
+        buffer.clear();
+        for (unsigned int i = 0; i < width;)
+        {
+            unsigned int copyLength = 0, runLength = 1;
+            while (above && i + copyLength < width && values[i + copyLength] == above[i + copyLength])
+                ++copyLength;
+            while (i + runLength < width && values[i + runLength] == values[i])
+                ++runLength;
+            if (copyLength >= runLength)
+            {
+                putVarint((uint64_t)copyLength << 1);
+                i += copyLength;
+            }
+            else
+            {
+                putVarint(((uint64_t)runLength << 1) | 1);
+                putVarint(((uint32_t)values[i] << 1) ^ (uint32_t)(values[i] >> 31));
+                i += runLength;
+            }
+        }
+        put(buffer.data(), buffer.size());
+        prev.assign(values, values + width);
+    }
+
+    /** Write the row index. */
+    void finish()
+    {
+        const uint64_t start = offset;
+        put(index.data(), index.size() * sizeof(uint64_t));
+        put(&start, sizeof start);
+    }
+
+private:
+    void put(const void *p, size_t length)
+    {
+        os.write((const char *)p, length);
+        offset += length;
+    }
+
+    void putVarint(uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            buffer.push_back((unsigned char)(v | 0x80));
+            v >>= 7;
+        }
+        buffer.push_back((unsigned char)v);
+    }
+
+    ostream &os;
+    unsigned int width;
+    uint32_t keyframe;
+    uint64_t offset;
+    vector<uint64_t> index;
+    vector<int> prev;
+    vector<unsigned char> buffer;
+};
+
+/** Field of an RleWriter file, kept compressed in memory with random access to its rows. */
+class RleReader
+{
+public:
+    RleReader() : keyframe(1), last(-1) {}
+
+    /**Routine description: Read a file of RleWriter.
+    Arguments:
+    - is  opened in binary mode
+    Return Value:
+     true if the file is complete, header() and row() are valid then
+    */
+    bool open(istream &is)
+    {
+        is.seekg(0, ios::end);
+        const uint64_t size = (uint64_t)is.tellg();
+        if (!is || size < sizeof(RawHeader) + sizeof(uint32_t) + sizeof(uint64_t))
+            return false;
+        data.resize(size);
+        is.seekg(0);
+        is.read((char *)data.data(), size);
+        memcpy(&head, data.data(), sizeof head);
+        memcpy(&keyframe, &data[sizeof head], sizeof keyframe);
+        uint64_t start;
+        memcpy(&start, &data[size - sizeof start], sizeof start);
+        // The index of height offsets lies between the coded rows and start, compared without wrapping
+        if (!is || memcmp(head.magic, "CEXR", 4) != 0 || head.version != RAWVERSION || keyframe == 0
+            || head.width == 0 || head.width > RAWMAXWIDTH
+            || start < sizeof head + sizeof keyframe || start > size - sizeof start
+            || (size - sizeof start - start) % sizeof(uint64_t) != 0
+            || (size - sizeof start - start) / sizeof(uint64_t) != head.height)
+            return false;
+        index.resize(head.height);
+        if (head.height > 0)
+            memcpy(index.data(), &data[start], head.height * sizeof(uint64_t));
+        // Every row lies between the keyframe interval and the index, in order, so decode never leaves data
+        uint64_t previous = sizeof head + sizeof keyframe;
+        for (unsigned int r = 0; r < head.height; ++r)
+        {
+            if (index[r] < previous || index[r] > start)
+                return false;
+            previous = index[r];
+        }
+        data.resize(start);
+        current.resize(head.width);
+        last = -1;
+        return true;
+    }
+
+    const RawHeader &header() const { return head; }
+
+    /**Routine description: Decode row imn, rows after the last one decoded continue from it.
+    Arguments:
+    - imn
+    - values  receives header().width values
+    Return Value:
+     false if the row is corrupt
+    */
+    bool row(unsigned int imn, int *values)
+    {
+        if (imn >= head.height)
+            return false;
+        unsigned int r = imn - imn % keyframe;
+        if (last >= (long long)r && last <= (long long)imn)
+            r = (unsigned int)last + 1;
+        for (; r <= imn; ++r)
+        {
+            if (!decode(r))
+            {
+                last = -1;
+                return false;
+            }
+            last = r;
+        }
+        copy(current.begin(), current.end(), values);
+        return true;
+    }
+
+private:
+    bool getVarint(uint64_t &pos, uint64_t end, uint64_t &v) const
+    {
+        v = 0;
+        for (int shift = 0; pos < end && shift < 64; shift += 7)
+        {
+            const unsigned char b = data[pos++];
+            v |= (uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    /** Decode row r into current, which holds row r - 1 unless r is a keyframe. */
+    bool decode(unsigned int r)
+    {
+        uint64_t pos = index[r];
+        const uint64_t end = r + 1 < head.height ? index[r + 1] : data.size();
+        const bool key = r % keyframe == 0;
+        for (unsigned int i = 0; i < head.width;)
+        {
+            uint64_t h, v = 0;
+            if (!getVarint(pos, end, h) || (h >> 1) == 0 || (h >> 1) > head.width - i)
+                return false;
+            const unsigned int length = (unsigned int)(h >> 1);
+            if (h & 1)
+            {
+                if (!getVarint(pos, end, v))
+                    return false;
+                const int value = (int)((uint32_t)(v >> 1) ^ -(uint32_t)(v & 1));
+                fill(current.begin() + i, current.begin() + i + length, value);
+            }
+            else if (key)
+                return false;
+            i += length;
+        }
+        return pos == end;
+    }
+
+    RawHeader head;
+    uint32_t keyframe;
+    vector<unsigned char> data;     // Header and coded rows
+    vector<uint64_t> index;         // Offset of every row in data
+    vector<int> current;            // Row last decoded
+    long long last;
+};
+
+/** Field of an earlier run with its parameters, e.g. for the zoom reuse of calcMField. */
+struct PriorField
+{
+    RawHeader header;
+    vector<int> values;         // header.height rows of header.width codes
+};
+
+/**Routine description: Read the field of a writeRaw or RleWriter file.
+Arguments:
+- path
+- prior  receives the field
+Return Value:
+ true if the file is complete
+*/
+bool readPriorField(const string &path, PriorField &prior)
+{
+    ifstream is(path.c_str(), ios::binary);
+    RawHeader &h = prior.header;
+    if (!is.read((char *)&h, sizeof h))
+        return false;
+    const size_t size = (size_t)h.width * h.height;
+    if (memcmp(h.magic, "CEXR", 4) == 0)
+    {
+        RleReader reader;
+        if (!reader.open(is))
+            return false;
+        prior.values.resize(size);
+        for (unsigned int imn = 0; imn < h.height; ++imn)
+            if (!reader.row(imn, &prior.values[(size_t)imn * h.width]))
+                return false;
+        return true;
+    }
+    if (memcmp(h.magic, "CEXP", 4) != 0 || h.version != RAWVERSION || h.width > RAWMAXWIDTH
+        || (h.valueBytes != 1 && h.valueBytes != 2 && h.valueBytes != 4))
+        return false;
+    // The header has to describe exactly the rest of the file before its size is allocated
+    is.seekg(0, ios::end);
+    const uint64_t length = (uint64_t)is.tellg();
+    if (!is || length - sizeof h != (uint64_t)size * h.valueBytes)
+        return false;
+    is.seekg(sizeof h);
+    vector<char> bytes(size * h.valueBytes);
+    if (!is.read(bytes.data(), bytes.size()))
+        return false;
+    prior.values.resize(size);
+    for (size_t i = 0; i < size; ++i)
+    {
+        const char *v = &bytes[i * h.valueBytes];
+        if (h.valueBytes == 1)
+            prior.values[i] = (int8_t)*v;
+        else if (h.valueBytes == 2)
+            prior.values[i] = *(const int16_t *)v;
+        else
+            prior.values[i] = *(const int32_t *)v;
+    }
+    return true;
+}
+
+/**Routine description: Write the header of a NumPy .npy file (format 1.0) of shape (height, width).
+Arguments:
+- os     opened in binary mode
+- descr  type of the values, e.g. "<i4"
+- height
+- width
+Return Value:
+*/
+void writeNpyHeader(ostream &os, const string &descr, size_t height, unsigned int width)
+{
+    string dict = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': ("
+                  + to_string(height) + ", " + to_string(width) + "), }";
+    // Magic, version and length take 10 bytes, the dictionary ends with a newline at a multiple of 64
+    dict.append((64 - (10 + dict.size() + 1) % 64) % 64, ' ');
+    dict += '\n';
+    const char prefix[10] = {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0,
+                             (char)(dict.size() & 0xff), (char)(dict.size() >> 8)};
+    os.write(prefix, sizeof prefix);
+    os << dict;
+}
+
+/**Routine description: Write a field as NumPy .npy file of shape (numIm, width).
+Arguments:
+- os         opened in binary mode
+- field, size
+- width
+- veclength  selects the integer type by fieldValueBytes
+Return Value:
+*/
+void writeNpy(ostream &os, const int *field, size_t size, unsigned int width, unsigned int veclength)
+{
+    const unsigned int bytes = fieldValueBytes(veclength);
+    const uint16_t probe = 1;
+    const char order = bytes == 1 ? '|' : *(const char *)&probe == 1 ? '<' : '>';
+    writeNpyHeader(os, string(1, order) + "i" + to_string(bytes), size / width, width);
+    writeFieldValues(os, field, size, bytes);
+}
+
+/**Routine description: Write a float channel as NumPy .npy file of shape (numIm, width) in native byte order.
+Arguments:
+- os     opened in binary mode
+- values, size
+- width
+Return Value:
+*/
+void writeNpy(ostream &os, const float *values, size_t size, unsigned int width)
+{
+    const uint16_t probe = 1;
+    writeNpyHeader(os, *(const char *)&probe == 1 ? "<f4" : ">f4", size / width, width);
+    os.write((const char *)values, size * sizeof(float));
+}
+
+/**Routine description: Write a field as Wolfram Exchange Format, a packed array of machine integers with
+dimensions {numIm, width}, for BinaryDeserialize[ReadByteArray[file]] in Mathematica.
+The header "8:" is followed by the token 0xC1 of a packed array, the type (0, 1, 2 for Integer8/16/32 chosen
+by fieldValueBytes), the rank and the dimensions as varints and the values in little endian order.
+Arguments:
+- os         opened in binary mode
+- field, size
+- width
+- veclength  selects the integer type by fieldValueBytes
+Return Value:
+*/
+void writeWxf(ostream &os, const int *field, size_t size, unsigned int width, unsigned int veclength)
+{
+    const unsigned int bytes = fieldValueBytes(veclength);
+    string head = "8:\xc1";
+    head += (char)(bytes == 1 ? 0 : bytes == 2 ? 1 : 2);
+    const uint64_t dims[3] = {2, size / width, width};
+    for (int d = 0; d < 3; ++d)
+    {
+        // Varint: 7 bits per byte, least significant first, high bit set on all but the last byte
+        uint64_t v = dims[d];
+        while (v >= 0x80)
+        {
+            head += (char)((v & 0x7f) | 0x80);
+            v >>= 7;
+        }
+        head += (char)v;
+    }
+    os.write(head.data(), head.size());
+
+    vector<unsigned char> buffer;
+    for (size_t start = 0; start < size; start += width)
+    {
+        buffer.clear();
+        for (unsigned int ren = 0; ren < width; ++ren)
+        {
+            const uint32_t v = (uint32_t)field[start + ren];
+            for (unsigned int b = 0; b < bytes; ++b)
+                buffer.push_back((unsigned char)(v >> (8 * b)));
+        }
+        os.write((const char *)buffer.data(), buffer.size());
+    }
+}
+
+/**Routine description: Write the run metadata of -json: parameters, timing and the number of points per code.
+Arguments:
+- os
+- minRe, maxRe, minIm, maxIm, numRe, numIm, eps, veclength  parameters of calcMField
+- typeName    scalar type of the orbits
+- seconds     wall clock time of the calculation
+- cpuSeconds  processor time of the calculation, summed over the threads
+- field, size
+Return Value:
+*/
+void writeJson(ostream &os, CLD minRe, CLD maxRe, CLD minIm, CLD maxIm, unsigned int numRe, unsigned int numIm,
+               double eps, unsigned int veclength, const string &typeName, double seconds, double cpuSeconds,
+               const int *field, size_t size)
+{
+    // Codes range from -1 to veclength + 2, the small ones are counted in an array of at most 64k,
+    // so the memory does not grow with veclength
+    const int dense = (int)min<long long>((long long)veclength + 2, 1 << 16);
+    vector<size_t> counts((size_t)dense + 2, 0);
+    map<int, size_t> others;
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (field[i] >= -1 && field[i] <= dense)
+            ++counts[field[i] + 1];
+        else
+            ++others[field[i]];
+    }
+    for (size_t c = 0; c < counts.size(); ++c)
+    {
+        if (counts[c] > 0)
+            others[(int)c - 1] += counts[c];
+    }
+
+    ios::fmtflags flags = os.flags();
+    streamsize prec = os.precision();
+    os << setprecision(numeric_limits<long double>::max_digits10)
+       << "{\n  \"rectangle\": {\"minRe\": " << minRe << ", \"maxRe\": " << maxRe
+       << ", \"minIm\": " << minIm << ", \"maxIm\": " << maxIm << "},\n"
+       << "  \"numRe\": " << numRe << ", \"numIm\": " << numIm << ",\n"
+       << "  \"width\": " << numRe + 1 << ", \"height\": " << numIm << ",\n"
+       << "  \"reD\": " << (maxRe - minRe) / (long double)(1. + numRe)
+       << ", \"imD\": " << (maxIm - minIm) / (long double)(1. + numIm) << ",\n"
+       << setprecision(numeric_limits<double>::max_digits10)
+       << "  \"eps\": " << eps << ", \"VECLENGTH\": " << veclength << ",\n"
+       << "  \"type\": \"" << typeName << "\",\n"
+       << "  \"layout\": \"numIm rows from maxIm down to minIm of numRe + 1 values from minRe\",\n"
+       << "  \"seconds\": " << seconds << ", \"cpuSeconds\": " << cpuSeconds << ",\n"
+       << "  \"points\": " << size << ",\n  \"counts\": {";
+    for (map<int, size_t>::const_iterator it = others.begin(); it != others.end(); ++it)
+        os << (it == others.begin() ? "" : ", ") << "\"" << it->first << "\": " << it->second;
+    os << "}\n}\n";
+    os.flags(flags);
+    os.precision(prec);
+}
+
+//==============================================================
+// Images: palette of the notebook Blendown.nb and PNG / PPM writers.
+
+/** Colour stop of a blend, position in [0, 1] and RGB in [0, 1]. */
+struct BlendStop
+{
+    double x, r, g, b;
+};
+
+/**Routine description: Palette of myblend in Blendown.nb (t = 0.5) for the codes -1 to clip.
+As in the notebook a code v is shown as myblend[1/v], v <= 0 as myblend[0] (white), and as with MyClip
+codes above clip are shown as clip.
+Arguments:
+- clip  largest code with its own colour
+Return Value:
+ 3 bytes RGB for every code from -1 to clip
+*/
+vector<unsigned char> blendPalette(int clip)
+{
+    const double t = 0.5;
+    const BlendStop stops[] =
+    {
+        {0, 1, 1, 1}, {1. / 20000, 0.71, 0.71, 0.71}, {1. / 10000, 0, 0, 0},
+        {t / 200, 0.31, 0, 0.33}, {t / 60, 0.41, 0.2, 0.65}, {t / 41, 1, 0.02, 0.91},
+        {t / 32, 0, 0, 0.84}, {t / 27, 0.02, 0.53, 1}, {t / 24, 0.33, 0.96, 1},
+        {t / 16, 0.24, 0.92, 0}, {t / 11, 0.91, 0.9, 0.24}, {t / 7, 1, 1, 0},
+        {t / 3, 1, 0.5, 0}, {1, 1, 0, 0}
+    };
+    const int numStops = sizeof stops / sizeof stops[0];
+    vector<unsigned char> lut;
+    for (int v = -1; v <= clip; ++v)
+    {
+        const double x = v > 0 ? 1. / v : 0.;
+        int i = 1;
+        while (i < numStops - 1 && stops[i].x < x)
+            ++i;
+        const BlendStop &a = stops[i - 1], &b = stops[i];
+        const double f = min(1., max(0., (x - a.x) / (b.x - a.x)));
+        lut.push_back((unsigned char)lround(255. * (a.r + f * (b.r - a.r))));
+        lut.push_back((unsigned char)lround(255. * (a.g + f * (b.g - a.g))));
+        lut.push_back((unsigned char)lround(255. * (a.b + f * (b.b - a.b))));
+    }
+    return lut;
+}
+
+/**Routine description: Colour a row of codes with a palette of blendPalette.
+Arguments:
+- codes
+- width
+- lut   palette for the codes -1 to clip
+- rgb   receives 3 * width bytes
+Return Value:
+*/
+inline void colourRow(const int *codes, unsigned int width, const vector<unsigned char> &lut, unsigned char *rgb)
+{
+    const int clip = (int)lut.size() / 3 - 2;
+    for (unsigned int ren = 0; ren < width; ++ren)
+    {
+        const unsigned char *c = &lut[3 * (min(max(codes[ren], -1), clip) + 1)];
+        rgb[3 * ren] = c[0];
+        rgb[3 * ren + 1] = c[1];
+        rgb[3 * ren + 2] = c[2];
+    }
+}
+
+/**Routine description: Write a field as binary PPM (P6) image, row by row.
+Arguments:
+- os     opened in binary mode
+- field, size
+- width
+- lut    palette of blendPalette
+Return Value:
+*/
+void writePpm(ostream &os, const int *field, size_t size, unsigned int width, const vector<unsigned char> &lut)
+{
+    os << "P6\n" << width << " " << size / width << "\n255\n";
+    vector<unsigned char> rgb(3 * (size_t)width);
+    for (size_t start = 0; start < size; start += width)
+    {
+        colourRow(&field[start], width, lut, rgb.data());
+        os.write((const char *)rgb.data(), rgb.size());
+    }
+}
+
+/** CRC-32 of PNG chunks. */
+inline uint32_t crc32Update(uint32_t crc, const unsigned char *data, size_t length)
+{
+    static uint32_t table[256];
+    static bool ready = false;
+    if (!ready)
+    {
+        for (uint32_t n = 0; n < 256; ++n)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+                c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        ready = true;
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i)
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+/** Streaming PNG writer for 8 bit RGB rows.
+The zlib stream is a single deflate block with the fixed Huffman codes, matches are found with
+hash chains over a 32K window. Rows are filtered with Sub, which turns the runs of equal colours
+into runs of zeros, and the compressed bytes are written as IDAT chunks of up to 64K.
+*/
+class PngWriter
+{
+public:
+    PngWriter(ostream &os, unsigned int width, unsigned int height)
+        : os(os), width(width), bitBuffer(0), bitCount(0), adlerA(1), adlerB(0), pos(0), base(0),
+          head(1 << HASHBITS, -1), prev(WINDOW, -1)
+    {
+        os.write("\x89PNG\r\n\x1a\n", 8);
+        unsigned char ihdr[13];
+        putBig(ihdr, width);
+        putBig(ihdr + 4, height);
+        ihdr[8] = 8;        // bit depth
+        ihdr[9] = 2;        // RGB
+        ihdr[10] = ihdr[11] = ihdr[12] = 0;
+        chunk("IHDR", ihdr, sizeof ihdr);
+        out.push_back(0x78);    // zlib header: deflate, 32K window
+        out.push_back(0x01);
+        putBits(1, 1);          // final block
+        putBits(1, 2);          // fixed Huffman codes
+    }
+
+    /** Append a row of 3 * width bytes. */
+    void row(const unsigned char *rgb)
+    {
+        const size_t start = data.size();
+        data.push_back(1);      // filter Sub
+        for (unsigned int i = 0; i < 3 * width; ++i)
+            data.push_back(i < 3 ? rgb[i] : (unsigned char)(rgb[i] - rgb[i - 3]));
+        adler(&data[start], data.size() - start);
+        compress(false);
+    }
+
+    /** Compress the rest and close the image. */
+    void finish()
+    {
+        compress(true);
+        putSymbol(256);
+        if (bitCount > 0)
+            putBits(0, 8 - bitCount);
+        const uint32_t checksum = (adlerB << 16) | adlerA;
+        for (int shift = 24; shift >= 0; shift -= 8)
+            out.push_back((unsigned char)(checksum >> shift));
+        flushIdat();
+        chunk("IEND", 0, 0);
+    }
+
+private:
+    enum { WINDOW = 1 << 15, HASHBITS = 15, MINMATCH = 3, MAXMATCH = 258, CHAIN = 32 };
+
+    static void putBig(unsigned char *p, uint32_t v)
+    {
+        p[0] = (unsigned char)(v >> 24);
+        p[1] = (unsigned char)(v >> 16);
+        p[2] = (unsigned char)(v >> 8);
+        p[3] = (unsigned char)v;
+    }
+
+    void chunk(const char *type, const unsigned char *payload, size_t length)
+    {
+        unsigned char head[8];
+        putBig(head, (uint32_t)length);
+        memcpy(head + 4, type, 4);
+        os.write((const char *)head, 8);
+        if (length > 0)
+            os.write((const char *)payload, length);
+        uint32_t crc = crc32Update(0, head + 4, 4);
+        crc = crc32Update(crc, payload, length);
+        unsigned char tail[4];
+        putBig(tail, crc);
+        os.write((const char *)tail, 4);
+    }
+
+    void flushIdat()
+    {
+        if (!out.empty())
+            chunk("IDAT", out.data(), out.size());
+        out.clear();
+    }
+
+    void adler(const unsigned char *p, size_t length)
+    {
+        for (size_t i = 0; i < length; ++i)
+        {
+            adlerA = (adlerA + p[i]) % 65521;
+            adlerB = (adlerB + adlerA) % 65521;
+        }
+    }
+
+    /** Bits are packed starting with the least significant bit. */
+    void putBits(uint32_t bits, int count)
+    {
+        bitBuffer |= bits << bitCount;
+        bitCount += count;
+        while (bitCount >= 8)
+        {
+            out.push_back((unsigned char)bitBuffer);
+            bitBuffer >>= 8;
+            bitCount -= 8;
+        }
+    }
+
+    /** Huffman codes are packed starting with the most significant bit. */
+    void putCode(uint32_t code, int length)
+    {
+        uint32_t reversed = 0;
+        for (int i = 0; i < length; ++i)
+            reversed |= ((code >> i) & 1) << (length - 1 - i);
+        putBits(reversed, length);
+    }
+
+    /** Literal or length symbol with the fixed Huffman code. */
+    void putSymbol(int sym)
+    {
+        if (sym < 144)
+            putCode(0x30 + sym, 8);
+        else if (sym < 256)
+            putCode(0x190 + sym - 144, 9);
+        else if (sym < 280)
+            putCode(sym - 256, 7);
+        else
+            putCode(0xc0 + sym - 280, 8);
+    }
+
+    void putMatch(int length, int distance)
+    {
+        static const int lengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                           35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const int lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static const int distBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                         257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                         8193, 12289, 16385, 24577};
+        int l = 28;
+        while (lengthBase[l] > length)
+            --l;
+        putSymbol(257 + l);
+        putBits(length - lengthBase[l], lengthExtra[l]);
+        int d = 29;
+        while (distBase[d] > distance)
+            --d;
+        putCode(d, 5);
+        putBits(distance - distBase[d], d < 4 ? 0 : d / 2 - 1);
+    }
+
+    uint32_t hash(size_t p) const
+    {
+        const unsigned char *q = &data[p - base];
+        return ((q[0] << 10) ^ (q[1] << 5) ^ q[2]) & ((1 << HASHBITS) - 1);
+    }
+
+    void insert(size_t p)
+    {
+        const uint32_t h = hash(p);
+        prev[p & (WINDOW - 1)] = head[h];
+        head[h] = (long long)p;
+    }
+
+    /** Greedy LZ77 over the filtered rows, the last MAXMATCH bytes wait for more input unless final. */
+    void compress(bool final)
+    {
+        const size_t end = base + data.size();
+        const size_t limit = final ? end : (end > MAXMATCH ? end - MAXMATCH : 0);
+        while (pos < limit)
+        {
+            int bestLength = 0, bestDistance = 0;
+            if (pos + MINMATCH <= end)
+            {
+                const size_t maxLength = min((size_t)MAXMATCH, end - pos);
+                long long cand = head[hash(pos)];
+                for (int chain = 0; chain < CHAIN && cand >= 0 && pos - (size_t)cand <= WINDOW; ++chain)
+                {
+                    const unsigned char *a = &data[pos - base], *b = &data[(size_t)cand - base];
+                    size_t length = 0;
+                    while (length < maxLength && a[length] == b[length])
+                        ++length;
+                    if ((int)length > bestLength)
+                    {
+                        bestLength = (int)length;
+                        bestDistance = (int)(pos - (size_t)cand);
+                        if (length == maxLength)
+                            break;
+                    }
+                    const long long next = prev[(size_t)cand & (WINDOW - 1)];
+                    if (next >= cand)
+                        break;      // Slot was overwritten by a newer position
+                    cand = next;
+                }
+            }
+            if (bestLength >= MINMATCH)
+            {
+                putMatch(bestLength, bestDistance);
+                for (int i = 0; i < bestLength; ++i, ++pos)
+                {
+                    if (pos + MINMATCH <= end)
+                        insert(pos);
+                }
+            }
+            else
+            {
+                putSymbol(data[pos - base]);
+                if (pos + MINMATCH <= end)
+                    insert(pos);
+                ++pos;
+            }
+        }
+        // Keep the window behind pos
+        if (pos - base > 2 * WINDOW)
+        {
+            const size_t drop = pos - base - WINDOW;
+            data.erase(data.begin(), data.begin() + drop);
+            base += drop;
+        }
+        if (out.size() >= (1 << 16))
+            flushIdat();
+    }
+
+    ostream &os;
+    unsigned int width;
+    vector<unsigned char> data;     // Filtered rows from base on
+    vector<unsigned char> out;      // Compressed bytes of the next IDAT chunk
+    uint32_t bitBuffer;
+    int bitCount;
+    uint32_t adlerA, adlerB;
+    size_t pos, base;               // Next position to compress, position of data[0]
+    vector<long long> head, prev;   // Hash chains over absolute positions
+};
+
+/**Routine description: Write a field as PNG image with PngWriter, row by row.
+Arguments:
+- os     opened in binary mode
+- field, size
+- width
+- lut    palette of blendPalette
+Return Value:
+*/
+void writePng(ostream &os, const int *field, size_t size, unsigned int width, const vector<unsigned char> &lut)
+{
+    PngWriter png(os, width, (unsigned int)(size / width));
+    vector<unsigned char> rgb(3 * (size_t)width);
+    for (size_t start = 0; start < size; start += width)
+    {
+        colourRow(&field[start], width, lut, rgb.data());
+        png.row(rgb.data());
+    }
+    png.finish();
+}
+
+// Edge of the tiles of TilePyramid.
+#define TILESIZE 256
+
+/** XYZ tile pyramid of PNG tiles, dir/z/x/y.png with TILESIZE x TILESIZE pixels.
+Level z = levels() - 1 holds the field at full resolution, every lower level halves it by averaging
+2 x 2 pixels, down to level 0 that fits into a single tile. Rows are fed in from the top and travel
+down the levels as they come in, every level keeps only its current strip of TILESIZE rows.
+Tiles at the right and lower border are padded with white.
+*/
+class TilePyramid
+{
+public:
+    TilePyramid(const string &dir, unsigned int width, unsigned int height) : dir(dir), ok(true)
+    {
+        unsigned int numLevels = 1;
+        const unsigned int tile = TILESIZE;
+        while ((width > tile << (numLevels - 1) || height > tile << (numLevels - 1)) && numLevels < 24)
+            ++numLevels;
+        level.resize(numLevels);
+        for (int z = numLevels - 1; z >= 0; --z)
+        {
+            level[z].width = width;
+            level[z].height = height;
+            level[z].rows = 0;
+            level[z].strip.reserve(3 * (size_t)width * TILESIZE);
+            width = (width + 1) / 2;
+            height = (height + 1) / 2;
+        }
+    }
+
+    /** Number of zoom levels. */
+    int levels() const { return (int)level.size(); }
+
+    /** Append a row of 3 * width bytes at full resolution. */
+    void row(const unsigned char *rgb) { addRow(levels() - 1, rgb); }
+
+    /** Write the tiles of the last strips. */
+    void finish()
+    {
+        for (int z = levels() - 1; z >= 0; --z)
+        {
+            Level &l = level[z];
+            if (z > 0 && !l.pending.empty())
+            {
+                // Odd number of rows, the last one is averaged with itself
+                const vector<unsigned char> last = l.pending;
+                addRow(z, last.data(), false);
+            }
+            if (!l.strip.empty())
+                writeStrip(z);
+        }
+    }
+
+    /** True if all tiles could be written. */
+    bool good() const { return ok; }
+
+private:
+    struct Level
+    {
+        unsigned int width, height, rows;   // size, rows added
+        vector<unsigned char> strip;        // rows of the current strip of tiles
+        vector<unsigned char> pending;      // row waiting for its partner in the next level
+    };
+
+    /** Add a row to level z, with count it is also added to the strip. */
+    void addRow(int z, const unsigned char *rgb, bool count = true)
+    {
+        Level &l = level[z];
+        const size_t bytes = 3 * (size_t)l.width;
+        if (count)
+        {
+            l.strip.insert(l.strip.end(), rgb, rgb + bytes);
+            ++l.rows;
+            if (l.rows % TILESIZE == 0)
+                writeStrip(z);
+        }
+        if (z == 0)
+            return;
+        if (l.pending.empty() && count)
+        {
+            l.pending.assign(rgb, rgb + bytes);
+            return;
+        }
+        // Average 2 x 2 pixels of the pending row and this one into the next level
+        const unsigned int half = level[z - 1].width;
+        vector<unsigned char> down(3 * (size_t)half);
+        for (unsigned int x = 0; x < half; ++x)
+        {
+            const unsigned int x1 = min(2 * x + 1, l.width - 1);
+            for (int c = 0; c < 3; ++c)
+            {
+                const unsigned int sum = l.pending[6 * x + c] + l.pending[3 * x1 + c] + rgb[6 * x + c] + rgb[3 * x1 + c];
+                down[3 * x + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+        l.pending.clear();
+        addRow(z - 1, down.data());
+    }
+
+    /** Write the tiles of the strip of level z that ends with its last row. */
+    void writeStrip(int z)
+    {
+        Level &l = level[z];
+        const unsigned int rows = (unsigned int)(l.strip.size() / (3 * (size_t)l.width));
+        const unsigned int ty = (l.rows - 1) / TILESIZE;
+        vector<unsigned char> tile(3 * TILESIZE);
+        for (unsigned int tx = 0; tx * TILESIZE < l.width; ++tx)
+        {
+            const string column = dir + "/" + to_string(z) + "/" + to_string(tx);
+            error_code ec;
+            filesystem::create_directories(column, ec);
+            ofstream file((column + "/" + to_string(ty) + ".png").c_str(), ios::binary);
+            PngWriter png(file, TILESIZE, TILESIZE);
+            const unsigned int x0 = tx * TILESIZE, count = min((unsigned int)TILESIZE, l.width - x0);
+            for (unsigned int y = 0; y < TILESIZE; ++y)
+            {
+                fill(tile.begin(), tile.end(), 255);
+                if (y < rows)
+                    copy(&l.strip[3 * ((size_t)y * l.width + x0)], &l.strip[3 * ((size_t)y * l.width + x0 + count)],
+                         tile.begin());
+                png.row(tile.data());
+            }
+            png.finish();
+            ok = ok && file.good();
+        }
+        l.strip.clear();
+    }
+
+    string dir;
+    vector<Level> level;
+    bool ok;
+};
+
+/**Routine description: Write a field as TilePyramid, row by row.
+Arguments:
+- dir    root directory of the tiles
+- field, size
+- width
+- lut    palette of blendPalette
+Return Value:
+ number of zoom levels, 0 if a tile could not be written
+*/
+int writeTiles(const string &dir, const int *field, size_t size, unsigned int width, const vector<unsigned char> &lut)
+{
+    TilePyramid tiles(dir, width, (unsigned int)(size / width));
+    vector<unsigned char> rgb(3 * (size_t)width);
+    for (size_t start = 0; start < size; start += width)
+    {
+        colourRow(&field[start], width, lut, rgb.data());
+        tiles.row(rgb.data());
+    }
+    tiles.finish();
+    return tiles.good() ? tiles.levels() : 0;
+}
+
+/**Routine description: Classify a single starting point z.
+Arguments:
+- z      starting point
+- hist   scratch history of the orbit, its steps() are the maximum number of steps
+- eps    tolerance for the cycle detection, raised to CYCLEULPS ulps of the last step like the SIMD kernel
+- watch  optional in-loop cycle detection with the same tolerance
+- channels  optional, receives the channels of the point
+- index     of the point in the channels
+- overflowZero  see safeCalcLongAtZ
+- cyclePeriod   optional, receives the cycle length if the code is one, 0 for the other codes
+Return Value:
+ code of safeCalcLongAtZ, or the cycle length of CycleDetectDLONG if the orbit stayed bounded
+*/
+template<class T>
+int calcPointAtZ(complex<T> z, OrbitHistory<T> *hist, double eps, CycleWatch<T> *watch = 0,
+                 const FieldChannels *channels = 0, size_t index = 0, bool overflowZero = false,
+                 int *cyclePeriod = 0)
+{
+    int iksdeh = safeCalcLongAtZ(z, hist, watch, channels && channels->escape ? channels->escape + index : 0,
+                                 overflowZero);
+    int period = 0;
+    const double tol = hist->size() > 0
+                       ? max(eps, CYCLEULPS * (double)ScalarTraits<T>::epsilon() * (double)cabsT(hist->back(0))) : eps;
+    if (iksdeh == 0)
+    {
+        iksdeh = watch && watch->confirmed() ? watch->confirmed() : CycleDetectDLONG(hist, tol);
+        period = iksdeh;
+    }
+    if (channels)
+        recordChannels(*channels, index, *hist, z, period, tol);
+    if (cyclePeriod)
+        *cyclePeriod = period;
+    return iksdeh;
+}
+
+/**Routine description: Mariani-Silver subdivision of the tile [x0, x1] x [y0, y1] of a field.
+The border of the tile is evaluated. If it is uniform the interior gets the border value, otherwise
+the tile is split in four tiles sharing their borders, small tiles are evaluated point by point.
+Arguments:
+- field  row-major field of the given width
+- width
+- x0, y0, x1, y1  inclusive corners of the tile
+- eval   eval(ren, imn) returns the code of a point and stores it in field, repeated calls are cheap
+Return Value:
+*/
+template<class Eval>
+void subdivideTile(int *field, unsigned int width, unsigned int x0, unsigned int y0,
+                   unsigned int x1, unsigned int y1, Eval &eval)
+{
+    const int v = eval(x0, y0);
+    bool uniform = true;
+    for (unsigned int x = x0; x <= x1; ++x)
+    {
+        uniform = (eval(x, y0) == v) & uniform;
+        uniform = (eval(x, y1) == v) & uniform;
+    }
+    for (unsigned int y = y0 + 1; y < y1; ++y)
+    {
+        uniform = (eval(x0, y) == v) & uniform;
+        uniform = (eval(x1, y) == v) & uniform;
+    }
+    if (x1 - x0 < 2 || y1 - y0 < 2)
+        return;     // No interior
+
+    if (uniform)
+    {
+        for (unsigned int y = y0 + 1; y < y1; ++y)
+            for (unsigned int x = x0 + 1; x < x1; ++x)
+                field[(size_t)y * width + x] = v;
+    }
+    else if (x1 - x0 <= 4 && y1 - y0 <= 4)
+    {
+        for (unsigned int y = y0 + 1; y < y1; ++y)
+            for (unsigned int x = x0 + 1; x < x1; ++x)
+                eval(x, y);
+    }
+    else
+    {
+        const unsigned int xm = (x0 + x1) / 2, ym = (y0 + y1) / 2;
+        subdivideTile(field, width, x0, y0, xm, ym, eval);
+        subdivideTile(field, width, xm, y0, x1, ym, eval);
+        subdivideTile(field, width, x0, ym, xm, y1, eval);
+        subdivideTile(field, width, xm, ym, x1, y1, eval);
+    }
+}
+
+// Number of consecutive rows handed to a worker at once.
+#define BANDROWS 4
+// Number of bands the band workers may run ahead of the first band not printed yet.
+#define REORDERBANDS 16
+// Number of consecutive points handed to a worker at once by the SIMD stream.
+#define CHUNKPOINTS 64
+// Edge of the tiles handed to a worker at once by the subdivision.
+#define SUBTILE 64
+// Edge of the tiles of the tile cache, in lattice points.
+#define CACHETILE 64
+
+/** Global lattice of the tile cache, the point (gx, gy) lies at gx * re - i * gy * im.
+The spacings are rounded to 12 significant digits, so requests with the same spacing compute a
+lattice point from the same numbers and share its tiles bit for bit.
+*/
+struct CacheLattice
+{
+    long double re, im;     // spacing
+    long long x0, y0;       // lattice indices of the first point of the grid at (minRe, maxIm)
+    string spacing;         // the rounded spacings as text, part of the key of a tile
+};
+
+/**Routine description: Lattice of the tile cache for a grid of calcMField, see CacheLattice.
+Arguments:
+- minRe, maxRe, minIm, maxIm, numRe, numIm  parameters of calcMField
+Return Value:
+ the lattice, the grid lies on it once minRe = x0 * re and maxIm = -y0 * im
+*/
+CacheLattice cacheLattice(CLD minRe, CLD maxRe, CLD minIm, CLD maxIm, unsigned int numRe, unsigned int numIm)
 {
-    complex<long double> func = 1.;     // Current value of function
-    double safezero = pow(10., -18.);   // Null detection
+    char text[64];
+    CacheLattice lattice;
+    snprintf(text, sizeof text, "%.11Le", (maxRe - minRe) / (long double)(1. + numRe));
+    lattice.re = strtold(text, 0);
+    lattice.spacing = text;
+    snprintf(text, sizeof text, "%.11Le", (maxIm - minIm) / (long double)(1. + numIm));
+    lattice.im = strtold(text, 0);
+    lattice.spacing += string(",") + text;
+    lattice.x0 = llroundl(minRe / lattice.re);
+    lattice.y0 = llroundl(-maxIm / lattice.im);
+    return lattice;
+}
 
-    int n = 1;                          // Count the order
-    for (vector<complex<long double> >::iterator iter = myvec->begin(); iter != myvec->end(); iter++)
-    {
-        ++n;
-        func = exp(z * func);
-        *iter = func;
-        if (func != func)
-        {
-            // Found NaN:
-            return -1;
-        }
-        if (abs(func) < safezero)
-        {
-            return n;
-        }
-    }
-    return 0;
+/**Routine description: 64 bit FNV-1a hash.
+Arguments:
+- text
+Return Value:
+*/
+inline uint64_t fnv1a(const string &text)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : text)
+        h = (h ^ c) * 1099511628211ull;
+    return h;
 }
 
-/**Routine description:
+/** Switches for calcMField beyond the rectangle and the tolerances. */
+struct MFieldOptions
+{
+    unsigned int numThreads;    // number of worker threads, 0 for one per hardware thread
+    bool simd;                  // use the double precision stream kernel safeCalcStreamAtZ
+    bool fullHistory;           // keep every step instead of a ring of the last CYCLEMAX + 1
+    CycleMode cycle;
+    bool lambertW;              // code 1 without iterating where fixedPointAtZ applies
+    bool subdivide;             // Mariani-Silver subdivision with subdivideTile, scalar kernel only
+    unsigned int progressive;   // initial lattice step of the progressive passes, 0 for off, scalar kernel only
+    bool symmetry;              // reflect rows whose conjugate row is in the grid, not with progressive
+    bool text;                  // print the field to cout
+    bool header;                // print the rectangle and the step widths to cout before the field
+    string cache;               // directory of the tile cache, empty for off, scalar kernel only
+    bool overflowZero;          // an overflow followed by an underflow is a zero hit, see safeCalcLongAtZ
+    bool keep;                  // return the field, otherwise printed bands need not be kept
+
+    MFieldOptions() : numThreads(0), simd(false), fullHistory(false), cycle(CYCLE_SCAN), lambertW(false),
+        subdivide(false), progressive(0), symmetry(false), text(true), header(true), overflowZero(false),
+        keep(true) {}
+};
+
+/**Routine description: Record the run configuration that determines the codes in a RawHeader.
 Arguments:
+- header
+- typeName  scalar type of the orbits, ScalarTraits<T>::name()
+- mopts
 Return Value:
 */
-int CycleDetectDLONG(vector<complex<long double> > *myvec, double eps = pow(10, -6), int mymax = 255)
+void setRunConfig(RawHeader &header, const char *typeName, const MFieldOptions &mopts)
 {
-    //    cout << "cycleDetect1 with eps= "<<eps<<endl;
-    int result = 0;
-    int last = myvec->size() - 1;
-    complex<long double> lastElem = myvec->at(last);
-    complex<long double> nowElem;
-    for (int i = last - 1; i >= 0 && i >= last - mymax; --i)
-    {
-        ++result;
-        nowElem = myvec->at(i);
-        if (abs(nowElem - lastElem) < eps)
-        {
-            // cout << "cycleDetect1 with eps= "<<abs(myvec->at(i) - lastElem)<<endl;
-            return result;
-        }
-    }
-    return 0;
+    memset(header.type, 0, sizeof header.type);
+    strncpy(header.type, typeName, sizeof header.type - 1);
+    header.cycle = (uint32_t)mopts.cycle;
+    // The cache, subdivision and progressive passes run the scalar kernel whatever mopts.simd says
+    const bool simd = mopts.simd && mopts.cache.empty() && !mopts.subdivide && mopts.progressive == 0;
+    header.flags = (simd ? RAWSIMD : 0) | (mopts.fullHistory ? RAWFULLHISTORY : 0)
+                   | (mopts.lambertW ? RAWLAMBERTW : 0) | (mopts.overflowZero ? RAWOVERFLOWZERO : 0);
+    header.kernel = KERNELVERSION;
 }
 
-/** Helper function to manipulate output of values at z.
+/**Routine description: Whether two fields were computed with the same run configuration, see setRunConfig.
+Arguments:
+- a, b
+Return Value:
 */
-template<class T, class S>
-inline void printmy(T m, S z, bool printz = false)
+inline bool sameRunConfig(const RawHeader &a, const RawHeader &b)
 {
-    printz ? cout << m << " at z=" << z << '\n' : cout << m << " ";
+    return memcmp(a.type, b.type, sizeof a.type) == 0 && a.cycle == b.cycle && a.flags == b.flags
+           && a.kernel == b.kernel;
 }
 
 /**Routine description: Handler function for calculation of different starting points.
@@ -115,6 +2312,34 @@ maxIm - maxIm       first column Re @ maxIm
 |           |
 |minRe      |maxRe
 minIm - minIm       last column
+
+The rows are split into bands of BANDROWS rows which are handed out to numThreads workers.
+Every worker owns its orbit buffer and every point is computed from its grid index,
+so the printed field does not depend on the number of threads. The bands are printed in order as soon
+as they and all bands before them are complete. Without mopts.keep only a window of REORDERBANDS bands
+is kept and a worker waits before it runs further ahead of the first band not printed yet, so the
+memory does not grow with the number of rows.
+With mopts.simd the workers instead take chunks of points from a shared counter and feed them
+to the lanes of safeCalcStreamAtZ, the lane utilisation is reported on clog.
+With mopts.progressive the field is first computed on a lattice of every progressive-th point
+(rounded down to a power of two). Every pass halves the step and iterates a new point only if the
+corners of its cell in the previous lattice differ, otherwise it takes their value. A preview of
+the field, every point showing the value of its lattice point, is printed after each pass but the last.
+With mopts.symmetry rows below the real axis whose conjugate row is part of the grid are not computed
+but copied from it, as the orbit of conj(z) is the conjugate of the orbit of z.
+With mopts.cache the grid, which should lie on its cacheLattice, is covered by CACHETILE x CACHETILE
+tiles of the lattice. A tile is read from the cache directory, a file named by the FNV-1a hash of its
+lattice coordinates, spacing, eps, veclength, scalar type, KERNELVERSION and the cycle, history,
+lambertW and overflowZero switches, or computed as a whole and stored there as RleWriter file.
+Lattice points are computed from their lattice indices, so a tile does not depend on the request
+that computed it.
+The cache takes precedence over mopts.simd, subdivide, progressive and symmetry, channels are not collected.
+With a prior field, e.g. of a run on a coarser grid, the points of the grid that coincide with its points
+are copied instead of computed. That requires the same eps and veclength, the same run configuration of
+setRunConfig (scalar type, cycle mode, kernel switches and KERNELVERSION), steps of the prior grid that are
+integer multiples of the steps of this grid and an offset of whole steps between the grids, otherwise the
+prior field is not used. Copied points keep their initial channels and count as evaluated for mopts.subdivide
+and mopts.progressive.
 Arguments:
 - minRe
 - maxRe
@@ -122,60 +2347,537 @@ Arguments:
 - maxIm
 - numRe
 - numIm
-- myvec
+- veclength  maximum steps for computation at every point
 - eps
+- mopts      threads and kernel selection
+- channels     optional, receives the channels of every iterated point, the arrays hold numIm * (numRe + 1)
+               values initialised by the caller, rows mirrored by mopts.symmetry are copied with arg F negated
+- target       optional storage for the field, e.g. MappedRaster::values(), written in place by the workers
+- stream       optional, receives every row: from the band workers as soon as it is complete,
+               otherwise when the whole field is complete
+- prior        optional, field of an earlier run whose coincident points are reused, not with mopts.cache
 Return Value:
+The field, numIm rows of numRe + 1 codes with maxIm first, empty for an invalid area, with a target or
+if only a window of it was kept.
+The scalar type T of the orbits is independent of the long double grid parameters,
+without mopts.simd the whole kernel runs in T.
 */
-/**
-
-
-*/
-void calcMField(CLD minRe, CLD maxRe, CLD minIm, CLD maxIm,
+template<class T>
+vector<int> calcMField(CLD minRe, CLD maxRe, CLD minIm, CLD maxIm,
                 const unsigned int numRe, const unsigned int numIm,
-                vector<complex<long double> > *myvec, double eps)
+                const unsigned int veclength, double eps, const MFieldOptions &mopts,
+                const FieldChannels *channels = 0, int *target = 0, RowStream *stream = 0,
+                const PriorField *prior = 0)
 {
     if (minRe > maxRe || minIm > maxIm)
     {
-        cout << "Invalid area " << minRe << "," << maxRe << " ; " << minIm << "," << maxIm << '\n';
-        return;
+        (mopts.header ? cout : cerr) << "Invalid area " << minRe << "," << maxRe << " ; " << minIm << "," << maxIm << '\n';
+        return vector<int>();
     }
 
-    // StartVal:
-    const complex<long double> z0 = complex<long double>(minRe, maxIm);
-
-    complex<long double> z = z0;
     CLD reD = (maxRe - minRe) / (long double)(1. + numRe);
     CLD imD = (maxIm - minIm) / (long double)(1. + numIm);
+    const unsigned int width = numRe + 1;   // Points per row including minRe
+    const T minReT = minRe, maxImT = maxIm;
+    const T reDT = (T(maxRe) - minReT) / T(1. + numRe);
+    const T imDT = (maxImT - T(minIm)) / T(1. + numIm);
+
+    if (mopts.header)
+    {
+        cout << "\ncalcMField [" << minRe << ", " << maxRe << "][" << minIm << ", " << maxIm << "]";
+        cout << "\nd(Re)=" << reD << " d(Im)=" << imD << '\n';
+    }
+
+    unsigned int numThreads = mopts.numThreads;
+    if (numThreads == 0)
+    {
+        numThreads = thread::hardware_concurrency();
+        if (numThreads == 0)
+            numThreads = 1;
+    }
+
+    const size_t numPoints = (size_t)width * numIm;
+    atomic<unsigned int> nextBand(0);
+
+    // Row imn lies at Im = maxIm - imn * imD, its conjugate at row mirror - imn with mirror = 2 * maxIm / imD.
+    // Only used if mirror is an integer within a millionth of a row, the rows after mirror / 2 are copied.
+    const long double mirrorRow = roundl(2 * maxIm / imD);
+    const bool cached = !mopts.cache.empty();
+    const bool symmetric = mopts.symmetry && mopts.progressive == 0 && !cached && minIm < 0 && maxIm > 0
+                           && fabsl(2 * maxIm / imD - mirrorRow) < 1e-6L;
+    const unsigned int mirror = symmetric ? (unsigned int)mirrorRow : 0;
+    auto mirrored = [&](unsigned int imn)
+    {
+        return symmetric && 2 * imn > mirror && imn <= mirror;
+    };
+
+    // Points not computed yet by subdivision, progressive passes or zoom reuse
+    const int unset = numeric_limits<int>::min();
+
+    // Zoom reuse: point i of a prior row lies at minRe + (offRe + i * stepRe) * reD, row j at
+    // maxIm - (offIm + j * stepIm) * imD, so the prior field is used if all four are integers.
+    long long stepRe = 0, stepIm = 0, offRe = 0, offIm = 0;
+    bool zoom = false;
+    if (prior && !cached)
+    {
+        const RawHeader &h = prior->header;
+        CLD kRe = ((long double)h.maxRe - h.minRe) / h.width / reD;
+        CLD kIm = ((long double)h.maxIm - h.minIm) / (h.height + 1.) / imD;
+        CLD oRe = ((long double)h.minRe - minRe) / reD, oIm = (maxIm - (long double)h.maxIm) / imD;
+        auto integral = [](long double v)
+        {
+            return fabsl(v - roundl(v)) < 1e-6L;
+        };
+        RawHeader config = {};
+        setRunConfig(config, ScalarTraits<T>::name(), mopts);
+        zoom = h.eps == eps && h.veclength == veclength && kRe > 0.5 && kIm > 0.5
+               && integral(kRe) && integral(kIm) && integral(oRe) && integral(oIm);
+        if (!sameRunConfig(h, config))
+        {
+            zoom = false;
+            clog << "zoom: the prior field was computed with type " << string(h.type, strnlen(h.type, sizeof h.type))
+                 << ", cycle mode " << h.cycle << ", flags " << h.flags << " and kernel version " << h.kernel
+                 << ", not " << config.type << ", " << config.cycle << ", " << config.flags << " and "
+                 << config.kernel << ", computing without it\n";
+        }
+        else if (zoom)
+        {
+            stepRe = llroundl(kRe);
+            stepIm = llroundl(kIm);
+            offRe = llroundl(oRe);
+            offIm = llroundl(oIm);
+        }
+        else
+            clog << "zoom: the prior field is not aligned with the grid or has other eps or VECLENGTH\n";
+    }
+
+    // Band workers print the field themselves, in a window of REORDERBANDS bands if nothing else needs it
+    const bool bands = !cached && !mopts.simd && !mopts.subdivide && mopts.progressive == 0;
+    const bool printBands = mopts.text && bands && !symmetric;
+    const bool windowed = printBands && !mopts.keep && !target && !zoom;
+    const unsigned int windowRows = REORDERBANDS * BANDROWS;
+    vector<int> fieldBuffer(target ? 0 : windowed ? (size_t)width * min(numIm, windowRows) : numPoints);
+    int *const field = target ? target : fieldBuffer.data();
+    auto rowOf = [&](unsigned int imn)
+    {
+        return field + (size_t)(windowed ? imn % windowRows : imn) * width;
+    };
+    const unsigned int numBands = (numIm + BANDROWS - 1) / BANDROWS;
+    vector<string> bandText(printBands ? numBands : 0);     // formatted bands waiting for their turn
+    unsigned int printedBands = 0;
+    mutex printMutex;
+    condition_variable bandPrinted;
+
+    if ((mopts.subdivide || mopts.progressive > 0 || zoom) && !cached)
+        fill(field, field + numPoints, unset);
+    size_t inherited = 0;
+    if (zoom)
+    {
+        const RawHeader &h = prior->header;
+        for (unsigned int j = 0; j < h.height; ++j)
+        {
+            const long long imn = offIm + j * stepIm;
+            if (imn < 0 || imn >= numIm)
+                continue;
+            for (unsigned int i = 0; i < h.width; ++i)
+            {
+                const long long ren = offRe + i * stepRe;
+                if (ren < 0 || ren >= width)
+                    continue;
+                field[(size_t)imn * width + ren] = prior->values[(size_t)j * h.width + i];
+                ++inherited;
+            }
+        }
+    }
+
+    // Scalar kernel for the point (ren, imn), stores its code in field and optionally its cycle length
+    auto evalPoint = [&](OrbitHistory<T> &hist, CycleWatch<T> *pwatch, unsigned int ren, unsigned int imn,
+                         int *cyclePeriod = 0)
+    {
+        const size_t index = (size_t)imn * width + ren;
+        int *const row = rowOf(imn);
+        complex<T> z(minReT + T(ren) * reDT, maxImT - T(imn) * imDT);
+        if (mopts.lambertW && fixedPointAtZ(z, veclength, eps))
+        {
+            row[ren] = 1;
+            if (cyclePeriod)
+                *cyclePeriod = 0;
+        }
+        else
+            row[ren] = calcPointAtZ(z, &hist, eps, pwatch, channels, index, mopts.overflowZero, cyclePeriod);
+        return row[ren];
+    };
+
+    auto worker = [&]()
+    {
+        OrbitHistory<T> hist(veclength, mopts.fullHistory ? 0 : CYCLEMAX + 1);
+        CycleWatch<T> watch(eps, CYCLEULPS * ScalarTraits<T>::epsilon(), mopts.cycle);
+        CycleWatch<T> *pwatch = mopts.cycle != CYCLE_SCAN ? &watch : 0;
+        vector<int> periods(2 * (size_t)width);     // cycle lengths of this and the previous row, 0 for other codes
+        unsigned int band;
+        while ((band = nextBand.fetch_add(BANDROWS)) < numIm)
+        {
+            if (windowed)
+            {
+                // The slots of the band are free once the band REORDERBANDS before it is printed
+                unique_lock<mutex> lock(printMutex);
+                bandPrinted.wait(lock, [&]() { return band / BANDROWS < printedBands + REORDERBANDS; });
+            }
+            for (unsigned int imn = band; imn < numIm && imn < band + BANDROWS; ++imn)
+            {
+                if (mirrored(imn))
+                    continue;
+                int *const row = rowOf(imn);
+                int *const period = &periods[(imn & 1) * (size_t)width];
+                const int *const upper = &periods[(~imn & 1) * (size_t)width];
+                for (unsigned int ren = 0; ren < width; ++ren)
+                {
+                    if (zoom && row[ren] != unset)
+                    {
+                        period[ren] = 0;
+                        continue;
+                    }
+                    // Periods of the left and upper neighbours, as far as computed by this worker
+                    watch.hint(ren > 0 ? period[ren - 1] : 0, imn > band && !mirrored(imn - 1) ? upper[ren] : 0);
+                    evalPoint(hist, pwatch, ren, imn, &period[ren]);
+                }
+                if (stream)
+                    stream->row(imn, row);
+            }
+            if (printBands)
+            {
+                // Format the band outside the lock, then print it and the complete bands after it
+                // if all bands before it are printed
+                string text;
+                formatRows(text, rowOf(band), min((unsigned int)BANDROWS, numIm - band), width);
+                lock_guard<mutex> lock(printMutex);
+                bandText[band / BANDROWS].swap(text);
+                const unsigned int first = printedBands;
+                while (printedBands < numBands && !bandText[printedBands].empty())
+                {
+                    cout.write(bandText[printedBands].data(), bandText[printedBands].size());
+                    string().swap(bandText[printedBands]);
+                    ++printedBands;
+                }
+                if (printedBands > first)
+                {
+                    cout.flush();
+                    bandPrinted.notify_all();
+                }
+            }
+        }
+    };
+
+    // Subdivision: disjoint SUBTILE x SUBTILE tiles, so no point is shared between workers.
+    // Points filled from a uniform border keep their initial channels.
+    const unsigned int tilesRe = (width + SUBTILE - 1) / SUBTILE;
+    const size_t numTiles = (size_t)tilesRe * ((numIm + SUBTILE - 1) / SUBTILE);
+    atomic<size_t> nextTile(0), iterated(0);
+
+    auto subdivideWorker = [&]()
+    {
+        OrbitHistory<T> hist(veclength, mopts.fullHistory ? 0 : CYCLEMAX + 1);
+        CycleWatch<T> watch(eps, CYCLEULPS * ScalarTraits<T>::epsilon(), mopts.cycle);
+        CycleWatch<T> *pwatch = mopts.cycle != CYCLE_SCAN ? &watch : 0;
+        size_t count = 0;
+        auto eval = [&](unsigned int ren, unsigned int imn)
+        {
+            const int v = field[(size_t)imn * width + ren];
+            if (v != unset)
+                return v;
+            ++count;
+            return evalPoint(hist, pwatch, ren, imn);
+        };
+        size_t tile;
+        while ((tile = nextTile.fetch_add(1)) < numTiles)
+        {
+            const unsigned int x0 = (tile % tilesRe) * SUBTILE, y0 = (tile / tilesRe) * SUBTILE;
+            const unsigned int y1 = min(y0 + SUBTILE, numIm) - 1;
+            if (mirrored(y0) && mirrored(y1))
+                continue;   // The mirrored rows are contiguous, partly mirrored tiles are overwritten
+            subdivideTile(field, width, x0, y0, min(x0 + SUBTILE, width) - 1, y1, eval);
+        }
+        iterated += count;
+    };
+
+    // Progressive passes: a point lies on the lattice of step s if both indices are multiples of s
+    // or the last of their axis, so the lattice always covers the whole rectangle.
+    unsigned int step = 0;
+    atomic<unsigned int> nextRow(0);
+    auto onLattice = [](unsigned int i, unsigned int last, unsigned int s)
+    {
+        return i % s == 0 || i == last;
+    };
 
-    int iksdeh;
+    auto progressiveWorker = [&]()
+    {
+        OrbitHistory<T> hist(veclength, mopts.fullHistory ? 0 : CYCLEMAX + 1);
+        CycleWatch<T> watch(eps, CYCLEULPS * ScalarTraits<T>::epsilon(), mopts.cycle);
+        CycleWatch<T> *pwatch = mopts.cycle != CYCLE_SCAN ? &watch : 0;
+        const unsigned int coarse = 2 * step;   // lattice of the previous pass, read only in this pass
+        size_t count = 0;
+        unsigned int imn;
+        while ((imn = nextRow.fetch_add(1)) < numIm)
+        {
+            if (!onLattice(imn, numIm - 1, step))
+                continue;
+            const unsigned int y0 = imn - imn % coarse, y1 = min(y0 + coarse, numIm - 1);
+            for (unsigned int ren = 0; ren < width; ++ren)
+            {
+                const size_t index = (size_t)imn * width + ren;
+                if (!onLattice(ren, width - 1, step) || field[index] != unset)
+                    continue;
+                if (coarse <= mopts.progressive)
+                {
+                    const unsigned int x0 = ren - ren % coarse, x1 = min(x0 + coarse, width - 1);
+                    const int v = field[(size_t)y0 * width + x0];
+                    if (field[(size_t)y0 * width + x1] == v && field[(size_t)y1 * width + x0] == v
+                        && field[(size_t)y1 * width + x1] == v)
+                    {
+                        field[index] = v;
+                        continue;
+                    }
+                }
+                ++count;
+                evalPoint(hist, pwatch, ren, imn);
+            }
+        }
+        iterated += count;
+    };
 
-    cout << "\ncalcMField [" << minRe << ", " << maxRe << "][" << minIm << ", " << maxIm << "]";
-    cout << "\nd(Re)=" << reD << " d(Im)=" << imD << '\n';
-    for (unsigned int imn = 0; imn < numIm; ++imn)
+    // Tile cache: the tiles of the lattice overlapping the grid, taken one at a time by the workers
+    const CacheLattice lattice = cached ? cacheLattice(minRe, maxRe, minIm, maxIm, numRe, numIm) : CacheLattice();
+    auto floorTile = [](long long g)
+    {
+        return g >= 0 ? g / CACHETILE : -((-g + CACHETILE - 1) / CACHETILE);
+    };
+    const long long cacheTx0 = floorTile(lattice.x0), cacheTy0 = floorTile(lattice.y0);
+    const long long cacheTilesRe = cached ? floorTile(lattice.x0 + width - 1) - cacheTx0 + 1 : 0;
+    const size_t numCacheTiles = cached ? (size_t)cacheTilesRe * (floorTile(lattice.y0 + numIm - 1) - cacheTy0 + 1) : 0;
+    atomic<size_t> computedTiles(0), failedTiles(0);
+    if (cached)
     {
-        z = z0;
-        z.imag(z.imag() - ((long double)imn)*imD);
+        error_code ec;
+        filesystem::create_directories(mopts.cache, ec);
+    }
 
-        iksdeh = safeCalcLongAtZ(z, myvec);
-        if (iksdeh == 0)
+    auto cacheWorker = [&]()
+    {
+        OrbitHistory<T> hist(veclength, mopts.fullHistory ? 0 : CYCLEMAX + 1);
+        CycleWatch<T> watch(eps, CYCLEULPS * ScalarTraits<T>::epsilon(), mopts.cycle);
+        CycleWatch<T> *pwatch = mopts.cycle != CYCLE_SCAN ? &watch : 0;
+        vector<int> tile((size_t)CACHETILE * CACHETILE);
+        size_t t;
+        while ((t = nextTile.fetch_add(1)) < numCacheTiles)
         {
-            iksdeh = CycleDetectDLONG(myvec, eps);
+            const long long tx = cacheTx0 + (long long)(t % cacheTilesRe), ty = cacheTy0 + (long long)(t / cacheTilesRe);
+            const long long gx0 = tx * CACHETILE, gy0 = ty * CACHETILE;
+            char key[32], eps17[32];
+            snprintf(eps17, sizeof eps17, "%.17g", eps);
+            snprintf(key, sizeof key, "%016llx", (unsigned long long)fnv1a(
+                to_string(tx) + "," + to_string(ty) + "," + lattice.spacing + "," + eps17 + "," + to_string(veclength)
+                + "," + ScalarTraits<T>::name() + "," + to_string(KERNELVERSION) + "," + to_string((int)mopts.cycle)
+                + "," + to_string((int)mopts.lambertW) + "," + to_string((int)mopts.fullHistory)
+                + "," + to_string((int)mopts.overflowZero)));
+            const filesystem::path path = filesystem::path(mopts.cache) / (string(key) + ".rle");
+            // Rectangle of the tile in the convention of calcMField, the header guards against hash collisions
+            RawHeader expected = rawHeader(CACHETILE, CACHETILE, gx0 * lattice.re, (gx0 + CACHETILE) * lattice.re,
+                                           -(gy0 + CACHETILE + 1) * lattice.im, -gy0 * lattice.im, eps, veclength, 0);
+            setRunConfig(expected, ScalarTraits<T>::name(), mopts);
+
+            RleReader reader;
+            ifstream in(path, ios::binary);
+            bool found = in && reader.open(in);
+            const RawHeader &stored = reader.header();
+            found = found && stored.width == CACHETILE && stored.height == CACHETILE && stored.veclength == veclength
+                    && stored.eps == eps && stored.minRe == expected.minRe && stored.maxIm == expected.maxIm
+                    && sameRunConfig(stored, expected);
+            for (unsigned int y = 0; found && y < CACHETILE; ++y)
+                found = reader.row(y, &tile[(size_t)y * CACHETILE]);
+            in.close();
+
+            if (!found)
+            {
+                for (unsigned int y = 0; y < CACHETILE; ++y)
+                {
+                    for (unsigned int x = 0; x < CACHETILE; ++x)
+                    {
+                        const complex<T> z(T((gx0 + x) * lattice.re), T(-(gy0 + y) * lattice.im));
+                        tile[(size_t)y * CACHETILE + x] = mopts.lambertW && fixedPointAtZ(z, veclength, eps)
+                                                          ? 1 : calcPointAtZ(z, &hist, eps, pwatch, 0, 0,
+                                                                             mopts.overflowZero);
+                    }
+                }
+                // Written under a name of this process and thread, so other runs never read a partial tile
+                ostringstream suffix;
+#ifdef _WIN32
+                suffix << ".tmp" << GetCurrentProcessId() << "." << this_thread::get_id();
+#else
+                suffix << ".tmp" << getpid() << "." << this_thread::get_id();
+#endif
+                const filesystem::path temp = path.string() + suffix.str();
+                ofstream out(temp, ios::binary);
+                RleWriter rle(out, expected);
+                for (unsigned int y = 0; y < CACHETILE; ++y)
+                    rle.row(&tile[(size_t)y * CACHETILE]);
+                rle.finish();
+                out.close();
+                error_code ec;
+                if (out)
+                    filesystem::rename(temp, path, ec);
+                if (!out || ec)
+                {
+                    filesystem::remove(temp, ec);
+                    ++failedTiles;
+                }
+                ++computedTiles;
+            }
+
+            // Part of the tile inside the grid
+            const long long xa = max(gx0, lattice.x0), xb = min(gx0 + CACHETILE, lattice.x0 + (long long)width);
+            const long long ya = max(gy0, lattice.y0), yb = min(gy0 + CACHETILE, lattice.y0 + (long long)numIm);
+            for (long long gy = ya; gy < yb; ++gy)
+                copy(&tile[(size_t)(gy - gy0) * CACHETILE + (xa - gx0)], &tile[(size_t)(gy - gy0) * CACHETILE + (xb - gx0)],
+                     field + (size_t)(gy - lattice.y0) * width + (xa - lattice.x0));
         }
-        cout << '\n';
-        printmy(iksdeh, z);
+    };
+
+    atomic<size_t> nextChunk(0);
+    LaneStats lanes;
+    mutex lanesMutex;
 
-        // Add dRe:
-        for (unsigned int ren = 0; ren < numRe; ++ren)
+    auto simdWorker = [&]()
+    {
+        size_t pos = 0, end = 0;
+        auto next = [&](size_t &index, complex<double> &z)
         {
-            z += reD;
-            iksdeh = safeCalcLongAtZ(z, myvec);
-            if (iksdeh == 0)
+            for (;;)
             {
-                iksdeh = CycleDetectDLONG(myvec, eps);
+                if (pos == end)
+                {
+                    pos = nextChunk.fetch_add(CHUNKPOINTS);
+                    end = min(pos + CHUNKPOINTS, numPoints);
+                    if (pos >= numPoints)
+                    {
+                        pos = end = numPoints;
+                        return false;
+                    }
+                }
+                index = pos++;
+                if (mirrored(index / width) || (zoom && field[index] != unset))
+                    continue;
+                z = complex<double>(minRe + ((long double)(index % width)) * reD,
+                                    maxIm - ((long double)(index / width)) * imD);
+                if (!(mopts.lambertW && fixedPointAtZ(z, veclength, eps)))
+                    return true;
+                field[index] = 1;   // Resolved by the closed form, no lane needed
             }
-            printmy(iksdeh, z);
+        };
+        LaneStats stats;
+        safeCalcStreamAtZ(next, field, veclength, eps, mopts.cycle, stats, channels, mopts.overflowZero);
+        lock_guard<mutex> lock(lanesMutex);
+        lanes.busy += stats.busy;
+        lanes.slots += stats.slots;
+    };
+
+    if (mopts.progressive > 0 && !cached)
+    {
+        for (step = 1; 2 * step <= mopts.progressive; step *= 2)
+            ;
+        for (unsigned int pass = 1; ; ++pass)
+        {
+            nextRow = 0;
+            vector<thread> pool;
+            for (unsigned int t = 1; t < numThreads; ++t)
+                pool.push_back(thread(progressiveWorker));
+            progressiveWorker();
+            for (unsigned int t = 0; t < pool.size(); ++t)
+                pool[t].join();
+            clog << "progressive pass " << pass << ", step " << step << ": iterated " << iterated
+                 << " of " << numPoints << " points\n";
+            if (step == 1)
+                break;
+
+            vector<int> preview(numPoints);
+            for (unsigned int imn = 0; imn < numIm; ++imn)
+                for (unsigned int ren = 0; ren < width; ++ren)
+                    preview[(size_t)imn * width + ren] = field[(size_t)(imn - imn % step) * width + ren - ren % step];
+            // With -json cout carries only the final field
+            ostream &previewOut = mopts.header ? cout : clog;
+            previewOut << "\nprogressive pass " << pass << ", step " << step;
+            printField(previewOut, preview.data(), preview.size(), width);
+            previewOut << '\n' << flush;
+            step /= 2;
+        }
+    }
+    else
+    {
+        vector<thread> pool;
+        for (unsigned int t = 1; t < numThreads; ++t)
+            pool.push_back(cached ? thread(cacheWorker) : mopts.subdivide ? thread(subdivideWorker)
+                           : mopts.simd ? thread(simdWorker) : thread(worker));
+        cached ? cacheWorker() : mopts.subdivide ? subdivideWorker() : mopts.simd ? simdWorker() : worker();
+        for (unsigned int t = 0; t < pool.size(); ++t)
+            pool[t].join();
+    }
+
+    if (symmetric)
+    {
+        unsigned int rows = 0;
+        for (unsigned int imn = mirror / 2 + 1; imn <= mirror && imn < numIm; ++imn, ++rows)
+        {
+            copy(field + (size_t)(mirror - imn) * width, field + (size_t)(mirror - imn + 1) * width,
+                 field + (size_t)imn * width);
+            if (!channels)
+                continue;
+            const size_t from = (size_t)(mirror - imn) * width, to = (size_t)imn * width;
+            for (int *channel : {channels->iterations, channels->escape, channels->transient})
+                if (channel)
+                    copy(channel + from, channel + from + width, channel + to);
+            for (float *channel : {channels->absF, channels->multiplier})
+                if (channel)
+                    copy(channel + from, channel + from + width, channel + to);
+            if (channels->argF)
+                for (unsigned int ren = 0; ren < width; ++ren)
+                    channels->argF[to + ren] = -channels->argF[from + ren];
+        }
+        clog << "symmetry: mirrored " << rows << " of " << numIm << " rows\n";
+    }
+
+    if (stream)
+    {
+        // Rows not sent by the band workers
+        for (unsigned int imn = 0; imn < numIm; ++imn)
+        {
+            if (!bands || mirrored(imn))
+                stream->row(imn, field + (size_t)imn * width);
         }
     }
+
+    if (zoom)
+        clog << "zoom: inherited " << inherited << " of " << numPoints << " points\n";
+    if (cached)
+    {
+        clog << "cache: computed " << computedTiles << " of " << numCacheTiles << " tiles in " << mopts.cache << '\n';
+        if (failedTiles > 0)
+            cerr << "Could not store " << failedTiles << " tiles in " << mopts.cache << '\n';
+    }
+    else if (mopts.subdivide && mopts.progressive == 0)
+        clog << "subdivision: iterated " << iterated << " of " << numPoints << " points\n";
+
+    if (mopts.simd && mopts.progressive == 0 && lanes.slots > 0)
+    {
+        ios::fmtflags flags = clog.flags();
+        streamsize prec = clog.precision();
+        clog << "lane utilisation: " << fixed << setprecision(1) << 100. * lanes.busy / lanes.slots
+             << "% of " << lanes.slots << " lane-steps\n";
+        clog.flags(flags);
+        clog.precision(prec);
+    }
+
+    if (mopts.text && !printBands)
+        printField(cout, field, numPoints, width, numThreads);
+    return windowed ? vector<int>() : fieldBuffer;
 }
 
 /**Routine description:
@@ -243,7 +2945,7 @@ Arguments:
 Return Value:
 */
 template <class T>
-inline void printvec(vector<T> *vec)
+inline void printvec(const vector<T> *vec)
 {
     int  n = 1;
     cout << '\n';
@@ -253,32 +2955,185 @@ inline void printvec(vector<T> *vec)
     }
 }
 
+/**Routine description: Name of the scalar type selected with -type.
+Arguments:
+- dtype  float, double, long or quad
+Return Value:
+ name of the type, empty if the type is unknown or not compiled in (quad needs WITH_FLOAT128)
+*/
+string scalarTypeName(const string &dtype)
+{
+    if (dtype == "float")
+        return ScalarTraits<float>::name();
+    if (dtype == "double")
+        return ScalarTraits<double>::name();
+    if (dtype == "long")
+        return ScalarTraits<long double>::name();
+#ifdef WITH_FLOAT128
+    if (dtype == "quad")
+        return ScalarTraits<__float128>::name();
+#endif
+    return "";
+}
+
+/**Routine description: Separate options of the form -name or -name=value from the positional arguments.
+Negative numbers like -1.5 stay positional.
+Arguments:
+- argc, argv  as passed to main, the options are removed from argv and argc is adjusted
+Return Value:
+ map name -> value, value is empty for plain switches
+*/
+map<string, string> parseOptions(int &argc, char *argv[])
+{
+    map<string, string> opts;
+    int kept = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg.size() > 1 && arg[0] == '-' && isalpha((unsigned char)arg[1]))
+        {
+            size_t eq = arg.find('=');
+            if (eq == string::npos)
+                opts[arg.substr(1)] = "";
+            else
+                opts[arg.substr(1, eq - 1)] = arg.substr(eq + 1);
+        }
+        else
+        {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    return opts;
+}
+
+/**Routine description: Check that every parsed option is one main knows, so a typo does not silently
+run with the defaults.
+Arguments:
+- opts  parsed options
+Return Value:
+ false if an option is unknown, an error is printed then
+*/
+bool knownOptions(const map<string, string> &opts)
+{
+    static const char *const names[] = {"threads", "kernel", "type", "history", "cycle", "escape", "lambertw",
+        "subdivide", "progressive", "symmetry", "raw", "mmap", "npy", "png", "ppm", "tiles", "clip", "stream",
+        "rle", "decode", "json", "wxf", "channels", "channelprefix", "cache", "zoom", "overflowzero"};
+    bool known = true;
+    for (map<string, string>::const_iterator it = opts.begin(); it != opts.end(); ++it)
+    {
+        if (find(begin(names), end(names), it->first) == end(names))
+        {
+            cerr << "Unknown option -" << it->first << '\n';
+            known = false;
+        }
+    }
+    return known;
+}
+
+/**Routine description: Value of an option that must be one of a few words.
+Arguments:
+- opts     parsed options
+- name     option without '-'
+- choices  the allowed values separated by '|', e.g. "scan|brent|newton"
+- value    receives the value, left unchanged if the option is missing
+Return Value:
+ false if the option is given with anything else, an error is printed then
+*/
+bool choiceOption(map<string, string> &opts, const char *name, const string &choices, string &value)
+{
+    if (!opts.count(name))
+        return true;
+    const string &text = opts[name];
+    const string bars = "|" + choices + "|";
+    if (text.empty() || text.find('|') != string::npos || bars.find("|" + text + "|") == string::npos)
+    {
+        cerr << "-" << name << " must be one of " << choices << ", not '" << text << "'\n";
+        return false;
+    }
+    value = text;
+    return true;
+}
+
+/**Routine description: Value of a numeric option that must be a whole number in [1, maxValue].
+Arguments:
+- opts      parsed options
+- name      option without '-'
+- maxValue
+- value     receives the number, left unchanged if the option is missing
+Return Value:
+ false if the option is given with anything else, an error is printed then
+*/
+bool positiveOption(map<string, string> &opts, const char *name, unsigned int maxValue, unsigned int &value)
+{
+    if (!opts.count(name))
+        return true;
+    const string &text = opts[name];
+    unsigned long v = 0;
+    const from_chars_result parsed = from_chars(text.data(), text.data() + text.size(), v);
+    if (parsed.ec != errc() || parsed.ptr != text.data() + text.size() || v < 1 || v > maxValue)
+    {
+        cerr << "-" << name << " must be a whole number from 1 to " << maxValue << ", not '" << text << "'\n";
+        return false;
+    }
+    value = (unsigned int)v;
+    return true;
+}
+
 /**Routine description:
 Arguments:
 Return Value:
 */
 int main(int argc, char *argv[])
 {
-    cout << "-------- Program to calculate Continued Exponential --------\n"
-            "F(n) = exp(z * F(n-1)\n"
-            "with dtype: long double.\n";
+    map<string, string> opts = parseOptions(argc, argv);
+    if (!knownOptions(opts))
+        return 1;
+    // -stream=- sends the frames to stdout, the text goes to stderr instead
+    ostream standardOut(cout.rdbuf());
+    if (opts.count("stream") && opts["stream"] == "-")
+    {
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        cout.rdbuf(cerr.rdbuf());
+    }
+    // Scalar type of the orbits: float, double, long (default) or quad
+    string dtype = "long";
+    if (!choiceOption(opts, "type", "float|double|long|quad", dtype))
+        return 1;
+    const string dtypeName = scalarTypeName(dtype);
+    if (dtypeName.empty())
+    {
+        cerr << "-type=" << dtype << " is not available, compile with WITH_FLOAT128\n";
+        return 1;
+    }
+
+    // With -json the run header goes to the sidecar and cout carries only the field
+    const bool header = !opts.count("json");
+    if (header)
+    {
+        cout << "-------- Program to calculate Continued Exponential --------\n"
+                "F(n) = exp(z * F(n-1)\n"
+                "with dtype: " << dtypeName << ".\n";
 
-    precision();
-    mylimits();
+        precision();
+        mylimits();
 
-    // TestArea: =================================
-    // =================================
+        // TestArea: =================================
+        // =================================
 
-    complex<long double> z1 = -2.475409836065573771 + 4.175609756097561132i;
-    vector<complex<long double> > *testvec = new vector<complex<long double> >(10);
-    int cycle = 0; // Saves exit code of the calculation.
-    cycle = safeCalcLongAtZ(z1, testvec);
-    cout << "Ergebnis Berechung: " << cycle;
-    printvec(testvec);
+        complex<long double> z1 = -2.475409836065573771 + 4.175609756097561132i;
+        OrbitHistory<long double> testvec(10);
+        int cycle = 0; // Saves exit code of the calculation.
+        cycle = safeCalcLongAtZ(z1, &testvec);
+        cout << "Ergebnis Berechung: " << cycle;
+        printvec(&testvec.data());
 
-    // Implementation: ===========================
-    // ===========================================
-    cout << "\n\nProceeding with specific calculation...";
+        // Implementation: ===========================
+        // ===========================================
+        cout << "\n\nProceeding with specific calculation...";
+    }
     // Standard-Parameter:
     long double minRe = -1., maxRe = 0.5;
     long double minIm = 2., maxIm = 3.;
@@ -291,8 +3146,39 @@ int main(int argc, char *argv[])
 
     // Input of parameters via arguments:
     // arg: [minRe, maxRe, minIm, maxIm], [numRe, numIm], [eps], [VECLENGTH]
+    // options: -threads=N, -kernel=scalar|simd, -type=float|double|long|quad, -history=ring|full, -cycle=scan|brent|newton,
+    //          -escape=file, -lambertw, -subdivide, -progressive[=step], -symmetry,
+    //          -raw=file, -mmap, -npy=file, -png=file, -ppm=file, -tiles=dir, -clip=N,
+    //          -stream=file|-, -rle=file, -decode=file, -json=file, -wxf=file,
+    //          -channels=iterations,escape,absf,argf,multiplier,transient, -channelprefix=path, -cache=dir,
+    //          -zoom=file, -overflowzero
+    MFieldOptions mopts;
+    if (!positiveOption(opts, "threads", 4096, mopts.numThreads))
+        return 1;
+    string kernel = "scalar", history = "ring", cycleMode = "scan";
+    if (!choiceOption(opts, "kernel", "scalar|simd", kernel) || !choiceOption(opts, "history", "ring|full", history)
+        || !choiceOption(opts, "cycle", "scan|brent|newton", cycleMode))
+        return 1;
+    mopts.simd = kernel == "simd";
+    mopts.fullHistory = history == "full";
+    mopts.cycle = cycleMode == "brent" ? CYCLE_BRENT : cycleMode == "newton" ? CYCLE_NEWTON : CYCLE_SCAN;
+    mopts.lambertW = opts.count("lambertw") > 0;
+    mopts.subdivide = opts.count("subdivide") > 0;
+    if (opts.count("progressive") && opts["progressive"].empty())
+        mopts.progressive = 8;
+    else if (!positiveOption(opts, "progressive", 1u << 30, mopts.progressive))   // 2 * step must not wrap
+        return 1;
+    mopts.symmetry = opts.count("symmetry") > 0;
+    mopts.overflowZero = opts.count("overflowzero") > 0;
+    // Binary output replaces the text field on cout
+    mopts.text = !opts.count("raw") && !opts.count("npy") && !opts.count("stream") && !opts.count("rle")
+                 && !opts.count("wxf");
+
+    mopts.header = header;
+    // Without outputs of the whole field the printed bands are not kept
+    mopts.keep = !mopts.text || opts.count("png") || opts.count("ppm") || opts.count("tiles") || !header;
 
-    if (argc <= 4)      // Show explanation for parameters and the input thereof
+    if (argc <= 4 && header)      // Show explanation for parameters and the input thereof
     {
         if (argc > 1) // User entered some parameters
             cout << "\nError parsing parameters: Using STANDARDPARAMETERS";
@@ -301,7 +3187,30 @@ int main(int argc, char *argv[])
                 << minRe << ", maxReal=" << maxRe << ", minImaginary=" << minIm
                 << ", maxImaginary=" << maxIm << "], [ticks on real-axis=" << numRe << ", ticks on imag-axis="
                 << numIm << "], [epsilon for zero-detection=" << eps
-                << "], [maximum steps for computation at every point=" << VECLENGTH << "]" << '\n';
+                << "], [maximum steps for computation at every point=" << VECLENGTH << "]"
+                << "\noptions: -threads=N (default: one per hardware thread), -kernel=scalar|simd (simd: double precision batches,"
+                << " approximate: codes of sensitive points can differ from -type=double)"
+                << ", -type=float|double|long|quad (scalar type, default long double)"
+                << ", -history=ring|full (orbit kept for the cycle detection)"
+                << ", -cycle=scan|brent|newton (cycle detection after or during the iteration)"
+                << ", -escape=file (order of divergence of every point)"
+                << ", -lambertw (closed form for the convergent region)"
+                << ", -subdivide (fill tiles with uniform border)"
+                << ", -progressive[=step] (coarse lattice first, default step 8, refined where neighbours differ)"
+                << ", -symmetry (copy rows mirrored at the real axis)"
+                << ", -raw=file (binary field with header), -mmap (write -raw in place as int32)"
+                << ", -npy=file (NumPy array), -wxf=file (packed array for BinaryDeserialize)"
+                << ", -png=file, -ppm=file (image in the colours of Blendown.nb)"
+                << ", -tiles=dir (pyramid of 256x256 PNG tiles dir/z/x/y.png), -clip=N (codes above N"
+                << " share a colour, default 24)"
+                << ", -stream=file|- (rows as binary frames while they are computed, - for stdout)"
+                << ", -rle=file (run-length and delta coded field), -decode=file (read a -rle file"
+                << " instead of computing), -json=file (run metadata, cout then only carries the field)"
+                << ", -channels=iterations,escape,absf,argf,multiplier,transient (further results per point as"
+                << " <prefix><name>.npy), -channelprefix=path"
+                << ", -cache=dir (grid snapped to a global lattice, tiles of it are reused from dir)"
+                << ", -zoom=file (copy the points of an earlier -raw or -rle result that lie on the grid)"
+                << ", -overflowzero (an exp overflow whose next step underflows counts as zero hit)" << '\n';
     }
 
     if (argc > 4)
@@ -323,13 +3232,289 @@ int main(int argc, char *argv[])
                 VECLENGTH = atoi(argv[8]);
             }
         }
-        cout << "\nusing eps= " << eps << "\nticks on real/imag axis: (" << numRe << ", " << numIm <<")"
-             << "\nusing vector of length " << VECLENGTH;
+        if (header)
+            cout << "\nusing eps= " << eps << "\nticks on real/imag axis: (" << numRe << ", " << numIm <<")"
+                 << "\nusing vector of length " << VECLENGTH;
+    }
+
+    // -decode=file reads the field of a -rle file with its parameters instead of computing it
+    RleReader decoder;
+    if (opts.count("decode"))
+    {
+        ifstream rleFile(opts["decode"].c_str(), ios::binary);
+        if (!decoder.open(rleFile) || decoder.header().width == 0)
+        {
+            cerr << "Could not read " << opts["decode"] << '\n';
+            return 1;
+        }
+        const RawHeader &stored = decoder.header();
+        minRe = stored.minRe;
+        maxRe = stored.maxRe;
+        minIm = stored.minIm;
+        maxIm = stored.maxIm;
+        numRe = stored.width - 1;
+        numIm = stored.height;
+        eps = stored.eps;
+        VECLENGTH = stored.veclength;
+        if (header)
+            cout << "\ndecoding " << opts["decode"] << " [" << minRe << ", " << maxRe << "][" << minIm << ", "
+                 << maxIm << "] with " << stored.width << "x" << numIm << " points";
+    }
+
+    // -cache=dir snaps the grid to the lattice of the tile cache, so overlapping requests share tiles
+    if (opts.count("cache") && !opts.count("decode"))
+    {
+        if (opts.count("channels") || opts.count("escape"))
+            cerr << "-cache does not collect -channels or -escape, computing without the cache\n";
+        else
+        {
+            mopts.cache = opts["cache"];
+            const CacheLattice lattice = cacheLattice(minRe, maxRe, minIm, maxIm, numRe, numIm);
+            minRe = lattice.x0 * lattice.re;
+            maxRe = minRe + (1. + numRe) * lattice.re;
+            maxIm = -lattice.y0 * lattice.im;
+            minIm = maxIm - (1. + numIm) * lattice.im;
+            if (header)
+                cout << "\ncache " << mopts.cache << ": snapped to [" << minRe << ", " << maxRe << "][" << minIm
+                     << ", " << maxIm << "]";
+        }
+    }
+
+    // -zoom=file reuses the points of an earlier -raw or -rle result that coincide with the grid
+    PriorField prior;
+    if (opts.count("zoom") && !readPriorField(opts["zoom"], prior))
+    {
+        cerr << "Could not read " << opts["zoom"] << '\n';
+        return 1;
+    }
+    const PriorField *pprior = opts.count("zoom") ? &prior : 0;
+
+    vector<int> field, escapeField;
+
+    // -channels=name,... collects further results per point, memory is only allocated for the named ones
+    const char *const channelNames[] = {"iterations", "escape", "absf", "argf", "multiplier", "transient"};
+    const size_t numPoints = (size_t)(numRe + 1) * numIm;
+    vector<int> iterations, transient;
+    vector<float> absF, argF, multiplier;
+    FieldChannels channels;
+    bool escapeChannel = false;
+    string channelList = opts.count("channels") ? opts["channels"] + "," : "";
+    for (size_t pos = 0, comma; (comma = channelList.find(',', pos)) != string::npos; pos = comma + 1)
+    {
+        const string name = channelList.substr(pos, comma - pos);
+        if (name == "iterations")
+            iterations.assign(numPoints, 0);
+        else if (name == "escape")
+            escapeChannel = true;
+        else if (name == "absf")
+            absF.assign(numPoints, 0.f);
+        else if (name == "argf")
+            argF.assign(numPoints, 0.f);
+        else if (name == "multiplier")
+            multiplier.assign(numPoints, 0.f);
+        else if (name == "transient")
+            transient.assign(numPoints, 0);
+        else if (!name.empty())
+            cerr << "Unknown channel " << name << '\n';
+    }
+    if (escapeChannel || opts.count("escape"))
+        escapeField.assign(numPoints, 0);
+    channels.iterations = iterations.empty() ? 0 : iterations.data();
+    channels.escape = escapeField.empty() ? 0 : escapeField.data();
+    channels.absF = absF.empty() ? 0 : absF.data();
+    channels.argF = argF.empty() ? 0 : argF.data();
+    channels.multiplier = multiplier.empty() ? 0 : multiplier.data();
+    channels.transient = transient.empty() ? 0 : transient.data();
+    const bool anyChannel = channels.iterations || channels.escape || channels.absF || channels.argF
+                            || channels.multiplier || channels.transient;
+    const FieldChannels *pchannels = anyChannel && !opts.count("decode") ? &channels : 0;
+
+    // Header of the binary outputs, with the run configuration of the field or of the decoded file
+    auto fieldHeader = [&](unsigned int valueBytes)
+    {
+        RawHeader h = rawHeader(numRe + 1, numIm, minRe, maxRe, minIm, maxIm, eps, VECLENGTH, valueBytes);
+        if (opts.count("decode"))
+        {
+            const RawHeader &stored = decoder.header();
+            memcpy(h.type, stored.type, sizeof h.type);
+            h.cycle = stored.cycle;
+            h.flags = stored.flags;
+            h.kernel = stored.kernel;
+        }
+        else
+            setRunConfig(h, dtypeName.c_str(), mopts);
+        return h;
+    };
+
+    // With -mmap the raw file is created up front as int32 field and written in place by the workers
+    MappedRaster raster;
+    if (opts.count("mmap") && opts.count("raw") && !raster.open(opts["raw"], fieldHeader(4)))
+        cerr << "Could not map " << opts["raw"] << ", writing it after the calculation\n";
+    int *target = raster.values();
+
+    ofstream streamFile;
+    RowStream *stream = 0;
+    if (opts.count("stream"))
+    {
+        if (opts["stream"] != "-")
+            streamFile.open(opts["stream"].c_str(), ios::binary);
+        stream = new RowStream(opts["stream"] != "-" ? streamFile : standardOut,
+                               fieldHeader(fieldValueBytes(VECLENGTH)));
+    }
+
+    const chrono::steady_clock::time_point started = chrono::steady_clock::now();
+    const clock_t startedCpu = clock();
+    if (opts.count("decode"))
+    {
+        field.resize((size_t)(numRe + 1) * numIm);
+        for (unsigned int imn = 0; imn < numIm; ++imn)
+        {
+            int *row = &field[(size_t)imn * (numRe + 1)];
+            if (!decoder.row(imn, row))
+            {
+                cerr << "Corrupt row " << imn << " in " << opts["decode"] << '\n';
+                return 1;
+            }
+            if (stream)
+                stream->row(imn, row);
+        }
+        if (target)
+        {
+            copy(field.begin(), field.end(), target);
+            field.clear();
+        }
+        if (mopts.text)
+            printField(cout, target ? target : field.data(), (size_t)(numRe + 1) * numIm, numRe + 1,
+                       mopts.numThreads > 0 ? mopts.numThreads : max(1u, thread::hardware_concurrency()));
     }
+    else if (dtype == "float")
+        field = calcMField<float>(minRe, maxRe, minIm, maxIm, numRe, numIm, VECLENGTH, eps, mopts,
+                                  pchannels, target, stream, pprior);
+    else if (dtype == "double")
+        field = calcMField<double>(minRe, maxRe, minIm, maxIm, numRe, numIm, VECLENGTH, eps, mopts,
+                                   pchannels, target, stream, pprior);
+#ifdef WITH_FLOAT128
+    else if (dtype == "quad")
+        field = calcMField<__float128>(minRe, maxRe, minIm, maxIm, numRe, numIm, VECLENGTH, eps, mopts,
+                                       pchannels, target, stream, pprior);
+#endif
+    else
+        field = calcMField<long double>(minRe, maxRe, minIm, maxIm, numRe, numIm, VECLENGTH, eps, mopts,
+                                        pchannels, target, stream, pprior);
 
-    vector<complex<long double> > *implVec = new vector<complex<long double> >(VECLENGTH);
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    const double cpuSeconds = (double)(clock() - startedCpu) / CLOCKS_PER_SEC;
 
-    calcMField(minRe, maxRe, minIm, maxIm, numRe, numIm, implVec, eps);
+    if (stream)
+    {
+        stream->finish();
+        if (!(opts["stream"] == "-" ? standardOut : streamFile))
+            cerr << "Could not write " << opts["stream"] << '\n';
+        delete stream;
+    }
+
+    const int *values = target ? target : field.data();
+    const size_t numValues = target ? (size_t)(numRe + 1) * numIm : field.size();
+    if (opts.count("rle"))
+    {
+        ofstream rleFile(opts["rle"].c_str(), ios::binary);
+        RleWriter rle(rleFile, fieldHeader(0));
+        for (size_t start = 0; start < numValues; start += numRe + 1)
+            rle.row(values + start);
+        rle.finish();
+        if (!rleFile)
+            cerr << "Could not write " << opts["rle"] << '\n';
+    }
+    if (opts.count("raw") && !target)
+    {
+        ofstream rawFile(opts["raw"].c_str(), ios::binary);
+        writeRaw(rawFile, values, numValues, fieldHeader(fieldValueBytes(VECLENGTH)));
+        if (!rawFile)
+            cerr << "Could not write " << opts["raw"] << '\n';
+    }
+    if (opts.count("npy"))
+    {
+        ofstream npyFile(opts["npy"].c_str(), ios::binary);
+        writeNpy(npyFile, values, numValues, numRe + 1, VECLENGTH);
+        if (!npyFile)
+            cerr << "Could not write " << opts["npy"] << '\n';
+    }
+
+    if (opts.count("wxf"))
+    {
+        ofstream wxfFile(opts["wxf"].c_str(), ios::binary);
+        writeWxf(wxfFile, values, numValues, numRe + 1, VECLENGTH);
+        if (!wxfFile)
+            cerr << "Could not write " << opts["wxf"] << '\n';
+    }
+
+    if (opts.count("png") || opts.count("ppm") || opts.count("tiles"))
+    {
+        // Clipping as MyClip in ImportBigData.nb
+        const int clip = opts.count("clip") ? max(1, atoi(opts["clip"].c_str())) : 24;
+        const vector<unsigned char> lut = blendPalette(clip);
+        if (opts.count("png"))
+        {
+            ofstream pngFile(opts["png"].c_str(), ios::binary);
+            writePng(pngFile, values, numValues, numRe + 1, lut);
+            if (!pngFile)
+                cerr << "Could not write " << opts["png"] << '\n';
+        }
+        if (opts.count("ppm"))
+        {
+            ofstream ppmFile(opts["ppm"].c_str(), ios::binary);
+            writePpm(ppmFile, values, numValues, numRe + 1, lut);
+            if (!ppmFile)
+                cerr << "Could not write " << opts["ppm"] << '\n';
+        }
+        if (opts.count("tiles"))
+        {
+            const int levels = writeTiles(opts["tiles"], values, numValues, numRe + 1, lut);
+            if (levels > 0)
+                clog << "tiles: " << levels << " zoom levels in " << opts["tiles"] << '\n';
+            else
+                cerr << "Could not write the tiles to " << opts["tiles"] << '\n';
+        }
+    }
+
+    if (!header)
+    {
+        ofstream jsonFile(opts["json"].c_str());
+        writeJson(jsonFile, minRe, maxRe, minIm, maxIm, numRe, numIm, eps, VECLENGTH, dtypeName,
+                  seconds, cpuSeconds, values, numValues);
+        if (!jsonFile)
+            cerr << "Could not write " << opts["json"] << '\n';
+    }
+
+    if (opts.count("escape") && pchannels)
+    {
+        // Order of divergence of every point in the layout of the field
+        ofstream escapeFile(opts["escape"].c_str());
+        printField(escapeFile, escapeField.data(), escapeField.size(), numRe + 1);
+        if (!escapeFile)
+            cerr << "Could not write " << opts["escape"] << '\n';
+    }
+
+    if (opts.count("channels") && pchannels)
+    {
+        // Every channel as NumPy array <prefix><name>.npy
+        const string prefix = opts.count("channelprefix") ? opts["channelprefix"] : "";
+        const int *intChannels[] = {channels.iterations, escapeChannel ? channels.escape : 0, 0, 0, 0, channels.transient};
+        const float *floatChannels[] = {0, 0, channels.absF, channels.argF, channels.multiplier, 0};
+        for (size_t c = 0; c < sizeof channelNames / sizeof channelNames[0]; ++c)
+        {
+            if (!intChannels[c] && !floatChannels[c])
+                continue;
+            const string path = prefix + channelNames[c] + ".npy";
+            ofstream channelFile(path.c_str(), ios::binary);
+            if (intChannels[c])
+                writeNpy(channelFile, intChannels[c], numPoints, numRe + 1, VECLENGTH);
+            else
+                writeNpy(channelFile, floatChannels[c], numPoints, numRe + 1);
+            if (!channelFile)
+                cerr << "Could not write " << path << '\n';
+        }
+    }
 
     return 0;
 }